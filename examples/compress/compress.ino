@@ -0,0 +1,114 @@
+#include <Arduino.h>
+#include "fmt.h"
+#include "fmt_arduino/checksum.h"
+#include "fmt_arduino/compress.h"
+
+// Compresses a trace of log lines with different window sizes and prints the
+// compression ratio, the throughput and the RAM used by the encoder. The
+// output is decompressed again and compared by CRC-32.
+
+// A sink that only counts the bytes and computes a CRC-32
+struct CrcSink
+{
+    fmt::crc32 crc;
+    size_t size = 0;
+
+    size_t write(const char *data, size_t n)
+    {
+        crc.update(data, n);
+        size += n;
+        return n;
+    }
+};
+
+// A sink that decompresses the data passed to it
+template <unsigned WINDOW_BITS, unsigned COUNT_BITS>
+struct DecodeSink
+{
+    CrcSink decoded;
+    fmt::lzss_decoder<CrcSink, WINDOW_BITS, COUNT_BITS> decoder{decoded};
+    size_t size = 0;
+
+    size_t write(const char *data, size_t n)
+    {
+        size += n;
+        return decoder.write(data, n);
+    }
+};
+
+const char *levels[] = {"DEBUG", "INFO", "INFO", "INFO", "WARN"};
+const char *sources[] = {"wifi", "mqtt", "bme280", "ota"};
+
+template <typename Sink>
+void writeTrace(Sink &out, int lines)
+{
+    for (int i = 0; i < lines; ++i)
+    {
+        fmt::format_to(out, "{:010} [{:<5}] {}: ", 1000 + i * 173, levels[i % 5], sources[i % 4]);
+        switch (i % 4)
+        {
+        case 0:
+            fmt::format_to(out, "rssi={} dBm channel={}\n", -50 - i % 17, 1 + i % 11);
+            break;
+        case 1:
+            fmt::format_to(out, "published {} bytes to home/sensor/{}\n", 20 + i % 40, i % 3);
+            break;
+        case 2:
+            fmt::format_to(out, "T={:.2f}C H={:.1f}% P={:.1f}hPa\n", 21 + (i % 29) * 0.07, 40 + (i % 23) * 0.4, 1013 + (i % 11) * 0.3);
+            break;
+        default:
+            fmt::format_to(out, "no update available\n");
+        }
+    }
+}
+
+template <unsigned WINDOW_BITS, unsigned COUNT_BITS>
+void benchmark(int lines)
+{
+    using Encoder = fmt::lzss_sink<CrcSink, WINDOW_BITS, COUNT_BITS>;
+
+    // Formatting only
+    CrcSink original;
+    uint32_t start = micros();
+    writeTrace(original, lines);
+    uint32_t formatTime = micros() - start;
+
+    // Formatting and compression
+    CrcSink compressed;
+    auto out = new Encoder(compressed);
+    start = micros();
+    writeTrace(*out, lines);
+    out->finish();
+    uint32_t compressTime = micros() - start;
+
+    // Decompress and compare
+    auto decode = new DecodeSink<WINDOW_BITS, COUNT_BITS>();
+    auto check = new fmt::lzss_sink<DecodeSink<WINDOW_BITS, COUNT_BITS>, WINDOW_BITS, COUNT_BITS>(*decode);
+    writeTrace(*check, lines);
+    check->finish();
+    decode->decoder.finish();
+
+    fmt::format_to(Serial, "window={:5} count={:3} ram={:5}: {} -> {} bytes ({:.1f}%), {:.1f} KB/s ({:.1f} KB/s without compression) {}\n",
+                   1 << WINDOW_BITS, 1 << COUNT_BITS, sizeof(Encoder), out->bytes_in(), out->bytes_out(),
+                   100.0 * out->bytes_out() / out->bytes_in(), out->bytes_in() * 1000.0 / compressTime,
+                   original.size * 1000.0 / formatTime,
+                   decode->decoded.crc.value() == original.crc.value() ? "ok" : "MISMATCH");
+    delete check;
+    delete decode;
+    delete out;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+}
+
+void loop()
+{
+    benchmark<8, 4>(500);
+    benchmark<10, 4>(500);
+    benchmark<10, 5>(500);
+    benchmark<12, 6>(500);
+
+    delay(10000);
+}
@@ -0,0 +1,85 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fmt.h"
+#include "fmt_arduino/from_chars.h"
+
+// Parses numbers with fmt::from_chars and with strtod/strtol and prints the
+// time per number. The results are compared bit by bit.
+
+const char *floats[] = {
+    "23.5", "-0.125", "1013.25", "3.14159265358979", "6.02214076e23",
+    "1e-7", "-1.5e-12", "0.30000000000000004", "-273.15",
+    "9007199254740993", "1.7976931348623157e308", "47.6062095"};
+
+const char *integers[] = {"0", "42", "-1", "65535", "-32768", "1234567",
+                          "2147483647", "-2147483648", "1000", "7"};
+
+const int count = sizeof(floats) / sizeof(*floats);
+const int intCount = sizeof(integers) / sizeof(*integers);
+
+void benchmarkFloats(int rounds)
+{
+    double results[count];
+    bool same = true;
+
+    uint32_t start = micros();
+    for (int r = 0; r < rounds; ++r)
+        for (int i = 0; i < count; ++i)
+            fmt::from_chars(floats[i], floats[i] + strlen(floats[i]), results[i]);
+    uint32_t fmtTime = micros() - start;
+
+    start = micros();
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            double value = strtod(floats[i], nullptr);
+            same = same && memcmp(&value, &results[i], sizeof(value)) == 0;
+        }
+    }
+    uint32_t strtodTime = micros() - start;
+
+    Serial.println(fmt::format("double: from_chars {:.3f} us, strtod {:.3f} us {}",
+                               double(fmtTime) / (rounds * count),
+                               double(strtodTime) / (rounds * count), same ? "ok" : "MISMATCH")
+                       .c_str());
+}
+
+void benchmarkIntegers(int rounds)
+{
+    long results[intCount];
+    bool same = true;
+
+    uint32_t start = micros();
+    for (int r = 0; r < rounds; ++r)
+        for (int i = 0; i < intCount; ++i)
+            fmt::from_chars(integers[i], integers[i] + strlen(integers[i]), results[i]);
+    uint32_t fmtTime = micros() - start;
+
+    start = micros();
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (int i = 0; i < intCount; ++i)
+            same = same && strtol(integers[i], nullptr, 10) == results[i];
+    }
+    uint32_t strtolTime = micros() - start;
+
+    Serial.println(fmt::format("long:   from_chars {:.3f} us, strtol {:.3f} us {}",
+                               double(fmtTime) / (rounds * intCount),
+                               double(strtolTime) / (rounds * intCount), same ? "ok" : "MISMATCH")
+                       .c_str());
+}
+
+void setup()
+{
+    Serial.begin(115200);
+}
+
+void loop()
+{
+    benchmarkFloats(200);
+    benchmarkIntegers(200);
+
+    delay(10000);
+}
@@ -0,0 +1,31 @@
+#include <Arduino.h>
+#include "fmt.h"
+#include "fmt_arduino/checksum.h"
+
+// Writes NMEA 0183 sentences to Serial. The checksum is computed while the
+// sentence is formatted, no copy of the sentence is kept in RAM.
+
+void writeGGA(uint32_t time, double lat, double lon, int satellites, double altitude)
+{
+    Serial.write('$');
+    auto out = fmt::checksummed<fmt::xor8>(Serial);
+    fmt::format_to(out, "GPGGA,{:06},{:09.4f},{},{:010.4f},{},1,{:02},0.9,{:.1f},M,46.9,M,,",
+                   time, fabs(lat), lat < 0 ? 'S' : 'N', fabs(lon), lon < 0 ? 'W' : 'E',
+                   satellites, altitude);
+    fmt::format_to(Serial, "*{:02X}\r\n", out.checksum());
+}
+
+void setup()
+{
+    Serial.begin(115200);
+}
+
+void loop()
+{
+    static uint32_t seconds = 0;
+    uint32_t time = (seconds / 3600 % 24) * 10000 + (seconds / 60 % 60) * 100 + seconds % 60;
+    writeGGA(time, 4807.038, 1131.0, 8, 545.4);
+    ++seconds;
+
+    delay(1000);
+}
@@ -0,0 +1,65 @@
+// Prints the peak stack usage of common formatting calls.
+// Build once as is and once with FMT_SMALL_STACK=1 (e.g. build_flags = -DFMT_SMALL_STACK=1) to compare.
+// On ESP32 the calls are measured in a separate task, elsewhere from setup().
+#if defined(ESP32) && !defined(FMT_STACK_PROBE_SIZE)
+// Measure up to the 4 KB that tasks are commonly given; the task below is sized for it.
+#define FMT_STACK_PROBE_SIZE 4096
+#elif defined(__AVR__) && !defined(FMT_STACK_PROBE_SIZE)
+// Boards such as the Uno have 2 KB of RAM in total.
+#define FMT_STACK_PROBE_SIZE 512
+#endif
+#include <Arduino.h>
+#include "fmt.h"
+#include "fmt_arduino/stack_usage.h"
+
+#pragma push_macro("F")
+#undef F
+#include <fmt/chrono.h>
+#pragma pop_macro("F")
+
+static char buffer[64];
+
+void report(const char *name, size_t used)
+{
+    // A call that used the whole probe may have used more.
+    const char *limit = used >= FMT_STACK_PROBE_SIZE ? " (probe limit)" : "";
+    fmt::format_to_n(buffer, sizeof(buffer) - 1, "{:<16} {:>5} bytes{}", name, used, limit).out[0] = '\0';
+    Serial.println(buffer);
+}
+
+void measure()
+{
+    report("format", fmt::measure_stack_usage([]
+                                              { (void)fmt::format("Counter {}", 42); }));
+    report("format_to_n", fmt::measure_stack_usage([]
+                                                   { fmt::format_to_n(buffer, sizeof(buffer), "Counter {}", 42); }));
+    report("float specs", fmt::measure_stack_usage([]
+                                                   { fmt::format_to_n(buffer, sizeof(buffer), "{:.3f} {:e} {}", 3.14159, 6.02e23, 0.1); }));
+    report("chrono", fmt::measure_stack_usage([]
+                                              { fmt::format_to_n(buffer, sizeof(buffer), "{:%H:%M:%S}", std::chrono::seconds(3725)); }));
+}
+
+#if defined(ESP32)
+void measureTask(void *)
+{
+    measure();
+    vTaskDelete(nullptr);
+}
+#endif
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(2000);
+#if defined(ESP32)
+    // The probe needs FMT_STACK_PROBE_SIZE bytes of free stack below the measured calls.
+    xTaskCreate(measureTask, "measure", 4096 + FMT_STACK_PROBE_SIZE, nullptr, 1, nullptr);
+#else
+    measure();
+#endif
+}
+
+void loop()
+{
+    delay(1000);
+}
@@ -7,6 +7,18 @@
 #define FMT_USE_LOCALE 0    // Disable locale support
 #define FMT_BUILTIN_TYPES 0 // Only include formatting types when they are used (increase per call size, but reduces library size)
 
+// Define FMT_USE_SCRATCH_BUFFER=1 to reuse a per-task buffer in fmt::format instead of a 500 byte stack buffer.
+// The largest message's capacity stays allocated until fmt::release_scratch_buffer() is called. It is not freed when
+// a thread or FreeRTOS task exits, so tasks that end must call it or they leak the buffer.
+#ifndef FMT_USE_SCRATCH_BUFFER
+#define FMT_USE_SCRATCH_BUFFER 0
+#endif
+
+// Define FMT_ALLOC_STATS=1 to count heap allocations made by fmt, see fmt::get_alloc_stats() and fmt::alloc_scope.
+#ifndef FMT_ALLOC_STATS
+#define FMT_ALLOC_STATS 0
+#endif
+
 // Backup conflicting macros
 #pragma push_macro("F")
 #pragma push_macro("B1")
@@ -19,17 +31,179 @@
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 #include <WString.h>
+#include <Print.h>
 
 // Restore conflicting macros
 #pragma pop_macro("F")
 #pragma pop_macro("B1")
 
-// Custom formatter
+// Custom formatter. String stores its length so it is formatted as a string_view instead of measuring it with strlen.
 template <>
-struct fmt::formatter<String> : fmt::formatter<const char *>
+struct fmt::formatter<String> : fmt::formatter<fmt::string_view>
 {
     auto format(const String &s, fmt::format_context &ctx) const
     {
-        return fmt::formatter<const char *>::format(s.c_str(), ctx);
+        return fmt::formatter<fmt::string_view>::format(fmt::string_view(s.c_str(), s.length()), ctx);
+    }
+};
+
+FMT_BEGIN_NAMESPACE
+namespace detail
+{
+    // A buffer appending to an Arduino String through a small staging area.
+    // String has no public way to write into its storage and set the length,
+    // so the output is appended in chunks with String::concat. Output that fits
+    // in the staging area is appended with a single allocation of the exact
+    // size; longer output reserves capacity geometrically. Str is a template
+    // parameter so that the growth can be tested with a counting string.
+    template <typename Str = String>
+    class string_buffer : public buffer<char>
+    {
+    private:
+        Str &str_;
+        // The capacity reserved by this buffer or 0 if nothing was reserved.
+        unsigned int reserved_ = 0;
+        char data_[64];
+
+        static void grow(buffer<char> &buf, size_t)
+        {
+            if (buf.size() == buf.capacity())
+                static_cast<string_buffer &>(buf).flush();
+        }
+
+    public:
+        explicit string_buffer(Str &str)
+            : buffer<char>(grow, data_, 0, sizeof(data_)), str_(str) {}
+        string_buffer(const string_buffer &) = delete;
+        void operator=(const string_buffer &) = delete;
+        ~string_buffer() { flush(); }
+
+        void flush()
+        {
+            auto n = static_cast<unsigned int>(size());
+            if (n == 0)
+                return;
+            unsigned int length = str_.length() + n;
+            if (length > reserved_)
+            {
+                // The first chunk reserves the exact size, later ones grow by half.
+                reserved_ = reserved_ == 0 ? length : max_of(length, reserved_ + reserved_ / 2);
+                str_.reserve(reserved_);
+            }
+            str_.concat(data(), n);
+            clear();
+        }
+    };
+
+    // A Print that appends to a format buffer, used to format Printable
+    // objects without an intermediate String. It can also only count the
+    // output and stop after max_width code points (for precision).
+    class print_adapter : public Print
+    {
+    private:
+        buffer<char> *buf_;
+        size_t max_width_;
+        size_t width_ = 0;
+        size_t size_ = 0;
+
+    public:
+        print_adapter(buffer<char> *buf, size_t max_width) : buf_(buf), max_width_(max_width) {}
+
+        size_t write(uint8_t c) override { return write(&c, 1); }
+
+        size_t write(const uint8_t *data, size_t size) override
+        {
+            if (max_width_ != max_value<size_t>() || !buf_)
+            {
+                // Count code points, i.e. bytes other than UTF-8 continuation bytes.
+                for (size_t i = 0; i < size; ++i)
+                {
+                    if ((data[i] & 0xc0) == 0x80)
+                        continue;
+                    if (width_ == max_width_)
+                    {
+                        size = i;
+                        break;
+                    }
+                    ++width_;
+                }
+            }
+            if (buf_)
+                buf_->append(data, data + size);
+            size_ += size;
+            return size;
+        }
+
+        auto width() const -> size_t { return width_; }
+        auto size() const -> size_t { return size_; }
+    };
+} // namespace detail
+
+FMT_BEGIN_EXPORT
+
+// Formats args and appends the result to the Arduino String out.
+inline auto vformat_to(String &out, string_view fmt, format_args args) -> String &
+{
+    detail::string_buffer<String> buf(out);
+    detail::vformat_to(buf, fmt, args);
+    return out;
+}
+
+// Appends the formatted output to out without a temporary std::string.
+//   String topic;
+//   fmt::format_to(topic, "sensors/{}/temp", id);
+template <typename... T>
+auto format_to(String &out, format_string<T...> fmt, T &&...args) -> String &
+{
+    return fmt::vformat_to(out, fmt.str, vargs<T...>{{args...}});
+}
+
+// Formats args and returns the result as an Arduino String.
+template <typename... T>
+FMT_NODISCARD auto format_arduino(format_string<T...> fmt, T &&...args) -> String
+{
+    String result;
+    fmt::vformat_to(result, fmt.str, vargs<T...>{{args...}});
+    return result;
+}
+
+// Formatter for Printable types such as IPAddress. printTo writes directly into the output; with a width the object is printed twice, once to measure it.
+template <typename T>
+struct formatter<T, char, enable_if_t<std::is_base_of<Printable, T>::value>>
+{
+private:
+    detail::dynamic_format_specs<> specs_;
+
+public:
+    FMT_CONSTEXPR auto parse(format_parse_context &ctx) -> const char *
+    {
+        return detail::parse_format_specs(ctx.begin(), ctx.end(), specs_, ctx, detail::type::string_type);
     }
-};
\ No newline at end of file
+
+    auto format(const Printable &value, format_context &ctx) const -> format_context::iterator
+    {
+        auto specs = specs_;
+        detail::handle_dynamic_spec(specs.dynamic_width(), specs.width, specs.width_ref, ctx);
+        detail::handle_dynamic_spec(specs.dynamic_precision(), specs.precision, specs.precision_ref, ctx);
+        size_t max_width = specs.precision >= 0 ? detail::to_unsigned(specs.precision) : detail::max_value<size_t>();
+        auto out = ctx.out();
+        if (specs.width == 0)
+        {
+            detail::print_adapter adapter(&detail::get_container(out), max_width);
+            value.printTo(adapter);
+            return out;
+        }
+        detail::print_adapter counter(nullptr, max_width);
+        value.printTo(counter);
+        auto print = [&](appender it)
+        {
+            detail::print_adapter adapter(&detail::get_container(it), max_width);
+            value.printTo(adapter);
+            return it;
+        };
+        return detail::write_padded<char>(out, specs, counter.size(), counter.width(), print);
+    }
+};
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
@@ -301,6 +301,33 @@ FMT_PRAGMA_CLANG(diagnostic push)
 #  define FMT_BUILTIN_TYPES 1
 #endif
 
+// Thread-local storage for per-thread state such as the error handler.
+#ifdef FMT_THREAD_LOCAL
+// Use the provided definition.
+#elif defined(__AVR__) || defined(ESP8266)
+#  define FMT_THREAD_LOCAL  // Single-threaded targets.
+#else
+#  define FMT_THREAD_LOCAL thread_local
+#endif
+
+// Reuse a per-thread growable buffer in vformat instead of a stack buffer.
+#ifndef FMT_USE_SCRATCH_BUFFER
+#  define FMT_USE_SCRATCH_BUFFER 0
+#endif
+
+// Smaller on-stack buffers for tasks with small stacks. Output that doesn't fit
+// spills to the heap (memory_buffer) or is flushed more often (iterator and
+// counting buffers).
+#ifndef FMT_SMALL_STACK
+#  define FMT_SMALL_STACK 0
+#endif
+#ifndef FMT_INLINE_BUFFER_SIZE
+#  define FMT_INLINE_BUFFER_SIZE (FMT_SMALL_STACK ? 128 : 500)
+#endif
+#ifndef FMT_ITERATOR_BUFFER_SIZE
+#  define FMT_ITERATOR_BUFFER_SIZE (FMT_SMALL_STACK ? 64 : 256)
+#endif
+
 #define FMT_APPLY_VARIADIC(expr) \
   using unused = int[];          \
   (void)unused { 0, (expr, 0)... }
@@ -672,6 +699,16 @@ struct formatter {
 // This function is intentionally not constexpr to give a compile-time error.
 FMT_NORETURN FMT_API void report_error(const char* message);
 
+/// A function called with the error message before a runtime error is
+/// reported. When exceptions are disabled it may transfer control out of the
+/// formatting function, e.g. with `longjmp`; if it returns the program is
+/// aborted.
+using error_handler = void (*)(const char* message);
+
+/// Sets the error handler of the calling thread and returns the previous one.
+FMT_API auto set_error_handler(error_handler handler) noexcept
+    -> error_handler;
+
 enum class presentation_type : unsigned char {
   // Common specifiers:
   none = 0,
@@ -1875,7 +1912,7 @@ template <typename OutputIt, typename T, typename Traits = buffer_traits>
 class iterator_buffer : public Traits, public buffer<T> {
  private:
   OutputIt out_;
-  enum { buffer_size = 256 };
+  enum { buffer_size = FMT_ITERATOR_BUFFER_SIZE };
   T data_[buffer_size];
 
   static FMT_CONSTEXPR void grow(buffer<T>& buf, size_t) {
@@ -1915,7 +1952,7 @@ class iterator_buffer<T*, T, fixed_buffer_traits> : public fixed_buffer_traits,
                                                     public buffer<T> {
  private:
   T* out_;
-  enum { buffer_size = 256 };
+  enum { buffer_size = FMT_ITERATOR_BUFFER_SIZE };
   T data_[buffer_size];
 
   static FMT_CONSTEXPR void grow(buffer<T>& buf, size_t) {
@@ -2003,7 +2040,7 @@ class iterator_buffer<
 // A buffer that counts the number of code units written discarding the output.
 template <typename T = char> class counting_buffer : public buffer<T> {
  private:
-  enum { buffer_size = 256 };
+  enum { buffer_size = FMT_ITERATOR_BUFFER_SIZE };
   T data_[buffer_size];
   size_t count_ = 0;
 
@@ -2231,7 +2268,8 @@ template <typename Context> class value {
   value(const T& named_arg) : value(named_arg.value) {}
 
   template <typename T,
-            FMT_ENABLE_IF(use_formatter<T>::value || !FMT_BUILTIN_TYPES)>
+            FMT_ENABLE_IF(use_formatter<T>::value ||
+                          (!FMT_BUILTIN_TYPES && !is_named_arg<T>::value))>
   FMT_CONSTEXPR20 FMT_INLINE value(T& x) : value(x, custom_tag()) {}
 
   FMT_ALWAYS_INLINE value(const named_arg_info<char_type>* args, size_t size)
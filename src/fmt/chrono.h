@@ -1223,16 +1223,18 @@ class tm_writer {
     *out_++ = static_cast<char>('0' + to_unsigned(value) % 10);
   }
   void write2(int value) {
-    const char* d = digits2(to_unsigned(value) % 100);
-    *out_++ = *d++;
-    *out_++ = *d;
+    char d[2];
+    copy2_digits(d, to_unsigned(value) % 100);
+    *out_++ = d[0];
+    *out_++ = d[1];
   }
   void write2(int value, pad_type pad) {
     unsigned int v = to_unsigned(value) % 100;
     if (v >= 10) {
-      const char* d = digits2(v);
-      *out_++ = *d++;
-      *out_++ = *d;
+      char d[2];
+      copy2_digits(d, v);
+      *out_++ = d[0];
+      *out_++ = d[1];
     } else {
       out_ = detail::write_padding(out_, pad);
       *out_++ = static_cast<char>('0' + v);
@@ -1683,8 +1685,14 @@ class get_locale {
 
  public:
   inline get_locale(bool localized, locale_ref loc) : has_locale_(localized) {
+#if FMT_USE_LOCALE
     if (localized)
       ::new (&locale_) std::locale(loc.template get<std::locale>());
+#else
+    // Without locale support the classic locale is always used.
+    ignore_unused(loc);
+    has_locale_ = false;
+#endif
   }
   inline ~get_locale() {
     if (has_locale_) locale_.~locale();
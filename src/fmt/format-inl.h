@@ -33,7 +33,13 @@
 FMT_BEGIN_NAMESPACE
 namespace detail {
 
+FMT_FUNC auto current_error_handler() noexcept -> error_handler& {
+  static FMT_THREAD_LOCAL error_handler handler = nullptr;
+  return handler;
+}
+
 FMT_FUNC void assert_fail(const char* file, int line, const char* message) {
+  if (auto handler = current_error_handler()) handler(message);
   // Use unchecked std::fprintf to avoid triggering another assertion when
   // writing to stderr fails.
   fprintf(stderr, "%s:%d: assertion failed: %s", file, line, message);
@@ -132,7 +138,16 @@ FMT_FUNC auto write_loc(appender out, loc_value value,
 #endif
 }  // namespace detail
 
+FMT_FUNC auto set_error_handler(error_handler handler) noexcept
+    -> error_handler {
+  auto& current = detail::current_error_handler();
+  auto previous = current;
+  current = handler;
+  return previous;
+}
+
 FMT_FUNC void report_error(const char* message) {
+  if (auto handler = detail::current_error_handler()) handler(message);
 #if FMT_USE_EXCEPTIONS
   // Use FMT_THROW instead of throw to avoid bogus unreachable code warnings
   // from MSVC.
@@ -275,7 +290,7 @@ template <> struct cache_accessor<float> {
   static auto get_cached_power(int k) noexcept -> uint64_t {
     FMT_ASSERT(k >= float_info<float>::min_k && k <= float_info<float>::max_k,
                "k is out of range");
-    static constexpr const uint64_t pow10_significands[] = {
+    static constexpr const uint64_t pow10_significands[] FMT_PROGMEM = {
         0x81ceb32c4b43fcf5, 0xa2425ff75e14fc32, 0xcad2f7f5359a3b3f,
         0xfd87b5f28300ca0e, 0x9e74d1b791e07e49, 0xc612062576589ddb,
         0xf79687aed3eec552, 0x9abe14cd44753b53, 0xc16d9a0095928a28,
@@ -302,7 +317,7 @@ template <> struct cache_accessor<float> {
         0x96769950b50d88f5, 0xbc143fa4e250eb32, 0xeb194f8e1ae525fe,
         0x92efd1b8d0cf37bf, 0xb7abc627050305ae, 0xe596b7b0c643c71a,
         0x8f7e32ce7bea5c70, 0xb35dbf821ae4f38c, 0xe0352f62a19e306f};
-    return pow10_significands[k - float_info<float>::min_k];
+    return load_table(&pow10_significands[k - float_info<float>::min_k]);
   }
 
   struct compute_mul_result {
@@ -370,7 +385,7 @@ template <> struct cache_accessor<double> {
     FMT_ASSERT(k >= float_info<double>::min_k && k <= float_info<double>::max_k,
                "k is out of range");
 
-    static constexpr const uint128_fallback pow10_significands[] = {
+    static constexpr const uint128_fallback pow10_significands[] FMT_PROGMEM = {
 #if FMT_USE_FULL_CACHE_DRAGONBOX
       {0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7b},
       {0x9faacf3df73609b1, 0x77b191618c54e9ad},
@@ -1035,9 +1050,9 @@ template <> struct cache_accessor<double> {
     };
 
 #if FMT_USE_FULL_CACHE_DRAGONBOX
-    return pow10_significands[k - float_info<double>::min_k];
+    return load_table(&pow10_significands[k - float_info<double>::min_k]);
 #else
-    static constexpr const uint64_t powers_of_5_64[] = {
+    static constexpr const uint64_t powers_of_5_64[] FMT_PROGMEM = {
         0x0000000000000001, 0x0000000000000005, 0x0000000000000019,
         0x000000000000007d, 0x0000000000000271, 0x0000000000000c35,
         0x0000000000003d09, 0x000000000001312d, 0x000000000005f5e1,
@@ -1056,7 +1071,7 @@ template <> struct cache_accessor<double> {
     int offset = k - kb;
 
     // Get base cache.
-    uint128_fallback base_cache = pow10_significands[cache_index];
+    uint128_fallback base_cache = load_table(&pow10_significands[cache_index]);
     if (offset == 0) return base_cache;
 
     // Compute the required amount of bit-shift.
@@ -1064,7 +1079,7 @@ template <> struct cache_accessor<double> {
     FMT_ASSERT(alpha > 0 && alpha < 64, "shifting error detected");
 
     // Try to recover the real cache.
-    uint64_t pow5 = powers_of_5_64[offset];
+    uint64_t pow5 = load_table(&powers_of_5_64[offset]);
     uint128_fallback recovered_cache = umul128(base_cache.high(), pow5);
     uint128_fallback middle_low = umul128(base_cache.low(), pow5);
 
@@ -1439,9 +1454,181 @@ FMT_FUNC void report_system_error(int error_code,
   do_report_error(format_system_error, error_code, message);
 }
 
+namespace detail {
+
+// State of a vformat buffer. The per-thread scratch state is trivially
+// destructible so no thread exit handler is registered; its memory is only
+// freed by release_scratch_buffer.
+struct scratch_state {
+  char* data;
+  size_t capacity;
+  size_t peak_size;
+  size_t reuse_count;
+  bool in_use;
+};
+
+// A buffer that formats into the memory of a scratch_state, growing it up to
+// the allocation budget. Output past the budget is discarded.
+class scratch_buffer : public buffer<char> {
+ private:
+  scratch_state& state_;
+  size_t limit_;
+  bool owned_;  // Free the memory on destruction.
+  bool grown_ = false;
+  bool truncated_ = false;
+  size_t kept_size_ = 0;
+  char discard_[32];
+
+  static FMT_FUNC void grow(buffer<char>& buf, size_t size) {
+    auto& self = static_cast<scratch_buffer&>(buf);
+    if (self.truncated_) {
+      buf.clear();
+      return;
+    }
+    size_t old_capacity = buf.capacity();
+    size_t new_capacity = max_of<size_t>(old_capacity + old_capacity / 2, 64);
+    if (size > new_capacity) new_capacity = size;
+    if (new_capacity > self.limit_) new_capacity = self.limit_;
+    if (new_capacity <= old_capacity) {
+      if (buf.size() < old_capacity) return;  // Let the caller fill it first.
+      self.truncated_ = true;
+      self.kept_size_ = buf.size();
+      ++alloc_counters().truncations;
+      self.set(self.discard_, sizeof(self.discard_));
+      buf.clear();
+      return;
+    }
+    auto& state = self.state_;
+    if (new_capacity > state.capacity) {
+      char* new_data = allocator<char>().allocate(new_capacity);
+      if (state.data) {
+        memcpy(new_data, state.data, buf.size());
+        allocator<char>().deallocate(state.data, state.capacity);
+      }
+      state.data = new_data;
+      state.capacity = new_capacity;
+      self.grown_ = true;
+    }
+    self.set(state.data, new_capacity);
+  }
+
+ public:
+  explicit scratch_buffer(scratch_state& state, bool owned = false)
+      : buffer<char>(grow, state.data, 0, state.capacity),
+        state_(state),
+        limit_(alloc_budget() != 0 ? alloc_budget() : max_value<size_t>()),
+        owned_(owned) {
+    if (capacity() > limit_) set(state.data, limit_);
+    state.in_use = true;
+  }
+  scratch_buffer(const scratch_buffer&) = delete;
+  void operator=(const scratch_buffer&) = delete;
+
+  ~scratch_buffer() {
+    state_.in_use = false;
+    state_.peak_size = max_of(state_.peak_size, output_size());
+    if (!grown_) ++state_.reuse_count;
+    if (owned_ && state_.data)
+      allocator<char>().deallocate(state_.data, state_.capacity);
+  }
+
+  auto output_size() const -> size_t {
+    return truncated_ ? kept_size_ : size();
+  }
+
+  auto str() const -> std::string {
+    size_t n = output_size();
+    return n != 0 ? std::string(state_.data, n) : std::string();
+  }
+};
+
+// A buffer that appends the output of one formatting call to `out` up to
+// `limit` characters. Output past the limit is discarded as in scratch_buffer,
+// so a memory_buffer behind `out` doesn't grow past the allocation budget.
+class budget_buffer : public buffer<char> {
+ private:
+  buffer<char>& out_;
+  size_t remaining_;
+  bool truncated_ = false;
+  char data_[FMT_ITERATOR_BUFFER_SIZE];
+
+  static FMT_FUNC void grow(buffer<char>& buf, size_t) {
+    if (buf.size() == buf.capacity()) static_cast<budget_buffer&>(buf).flush();
+  }
+
+  void flush() {
+    size_t n = min_of(size(), remaining_);
+    out_.append(data_, data_ + n);
+    remaining_ -= n;
+    if (n != size() && !truncated_) {
+      truncated_ = true;
+      ++alloc_counters().truncations;
+    }
+    clear();
+  }
+
+ public:
+  budget_buffer(buffer<char>& out, size_t limit)
+      : buffer<char>(grow, data_, 0, sizeof(data_)),
+        out_(out),
+        remaining_(limit) {}
+  budget_buffer(const budget_buffer&) = delete;
+  void operator=(const budget_buffer&) = delete;
+  ~budget_buffer() { flush(); }
+};
+
+// Formats `args` into `buf` without applying the allocation budget.
+FMT_FUNC void do_vformat_to(buffer<char>& buf, string_view fmt,
+                            format_args args, locale_ref loc) {
+  auto out = appender(buf);
+  if (fmt.size() == 2 && equal2(fmt.data(), "{}"))
+    return args.get(0).visit(default_arg_formatter<char>{out});
+  parse_format_string(
+      fmt, format_handler<char>{parse_context<char>(fmt), {out, args, loc}});
+}
+
+#if FMT_USE_SCRATCH_BUFFER
+FMT_FUNC auto current_scratch() noexcept -> scratch_state& {
+  static FMT_THREAD_LOCAL scratch_state state = {};
+  return state;
+}
+#endif
+
+}  // namespace detail
+
+#if FMT_USE_SCRATCH_BUFFER
+FMT_FUNC auto get_scratch_buffer_stats() noexcept -> scratch_buffer_stats {
+  const auto& state = detail::current_scratch();
+  return {state.capacity, state.peak_size, state.reuse_count};
+}
+
+FMT_FUNC void release_scratch_buffer() noexcept {
+  auto& state = detail::current_scratch();
+  if (state.in_use) return;
+  if (state.data)
+    detail::allocator<char>().deallocate(state.data, state.capacity);
+  state = {};
+}
+#endif  // FMT_USE_SCRATCH_BUFFER
+
 FMT_FUNC auto vformat(string_view fmt, format_args args) -> std::string {
   // Don't optimize the "{}" case to keep the binary size small and because it
   // can be better optimized in fmt::format anyway.
+#if FMT_USE_SCRATCH_BUFFER
+  auto& scratch = detail::current_scratch();
+  // Nested calls, e.g. from a formatter, use a local buffer.
+  if (!scratch.in_use) {
+    detail::scratch_buffer buffer(scratch);
+    detail::do_vformat_to(buffer, fmt, args, {});
+    return buffer.str();
+  }
+#endif
+  if (detail::alloc_budget() != 0) {
+    auto state = detail::scratch_state();
+    detail::scratch_buffer buffer(state, true);
+    detail::do_vformat_to(buffer, fmt, args, {});
+    return buffer.str();
+  }
   auto buffer = memory_buffer();
   detail::vformat_to(buffer, fmt, args);
   return to_string(buffer);
@@ -1451,11 +1638,11 @@ namespace detail {
 
 FMT_FUNC void vformat_to(buffer<char>& buf, string_view fmt, format_args args,
                          locale_ref loc) {
-  auto out = appender(buf);
-  if (fmt.size() == 2 && equal2(fmt.data(), "{}"))
-    return args.get(0).visit(default_arg_formatter<char>{out});
-  parse_format_string(
-      fmt, format_handler<char>{parse_context<char>(fmt), {out, args, loc}});
+  if (alloc_budget() != 0) {
+    budget_buffer limited(buf, alloc_budget());
+    return do_vformat_to(limited, fmt, args, loc);
+  }
+  do_vformat_to(buf, fmt, args, loc);
 }
 
 template <typename T> struct span {
@@ -1767,12 +1954,12 @@ inline auto is_printable(uint16_t x, const singleton* singletons,
   auto upper = x >> 8;
   auto lower_start = 0;
   for (size_t i = 0; i < singletons_size; ++i) {
-    auto s = singletons[i];
+    auto s = load_table(&singletons[i]);
     auto lower_end = lower_start + s.lower_count;
     if (upper < s.upper) break;
     if (upper == s.upper) {
       for (auto j = lower_start; j < lower_end; ++j) {
-        if (singleton_lowers[j] == (x & 0xff)) return false;
+        if (load_table(&singleton_lowers[j]) == (x & 0xff)) return false;
       }
     }
     lower_start = lower_end;
@@ -1781,8 +1968,8 @@ inline auto is_printable(uint16_t x, const singleton* singletons,
   auto xsigned = static_cast<int>(x);
   auto current = true;
   for (size_t i = 0; i < normal_size; ++i) {
-    auto v = static_cast<int>(normal[i]);
-    auto len = (v & 0x80) != 0 ? (v & 0x7f) << 8 | normal[++i] : v;
+    auto v = static_cast<int>(load_table(&normal[i]));
+    auto len = (v & 0x80) != 0 ? (v & 0x7f) << 8 | load_table(&normal[++i]) : v;
     xsigned -= len;
     if (xsigned < 0) break;
     current = !current;
@@ -1792,7 +1979,7 @@ inline auto is_printable(uint16_t x, const singleton* singletons,
 
 // This code is generated by support/printable.py.
 FMT_FUNC auto is_printable(uint32_t cp) -> bool {
-  static constexpr singleton singletons0[] = {
+  static constexpr singleton singletons0[] FMT_PROGMEM = {
       {0x00, 1},  {0x03, 5},  {0x05, 6},  {0x06, 3},  {0x07, 6},  {0x08, 8},
       {0x09, 17}, {0x0a, 28}, {0x0b, 25}, {0x0c, 20}, {0x0d, 16}, {0x0e, 13},
       {0x0f, 4},  {0x10, 3},  {0x12, 18}, {0x13, 9},  {0x16, 1},  {0x17, 5},
@@ -1801,7 +1988,7 @@ FMT_FUNC auto is_printable(uint32_t cp) -> bool {
       {0x31, 2},  {0x32, 1},  {0xa7, 2},  {0xa9, 2},  {0xaa, 4},  {0xab, 8},
       {0xfa, 2},  {0xfb, 5},  {0xfd, 4},  {0xfe, 3},  {0xff, 9},
   };
-  static constexpr unsigned char singletons0_lower[] = {
+  static constexpr unsigned char singletons0_lower[] FMT_PROGMEM = {
       0xad, 0x78, 0x79, 0x8b, 0x8d, 0xa2, 0x30, 0x57, 0x58, 0x8b, 0x8c, 0x90,
       0x1c, 0x1d, 0xdd, 0x0e, 0x0f, 0x4b, 0x4c, 0xfb, 0xfc, 0x2e, 0x2f, 0x3f,
       0x5c, 0x5d, 0x5f, 0xb5, 0xe2, 0x84, 0x8d, 0x8e, 0x91, 0x92, 0xa9, 0xb1,
@@ -1828,7 +2015,7 @@ FMT_FUNC auto is_printable(uint32_t cp) -> bool {
       0xfe, 0xff, 0x53, 0x67, 0x75, 0xc8, 0xc9, 0xd0, 0xd1, 0xd8, 0xd9, 0xe7,
       0xfe, 0xff,
   };
-  static constexpr singleton singletons1[] = {
+  static constexpr singleton singletons1[] FMT_PROGMEM = {
       {0x00, 6},  {0x01, 1}, {0x03, 1},  {0x04, 2}, {0x08, 8},  {0x09, 2},
       {0x0a, 5},  {0x0b, 2}, {0x0e, 4},  {0x10, 1}, {0x11, 2},  {0x12, 5},
       {0x13, 17}, {0x14, 1}, {0x15, 2},  {0x17, 2}, {0x19, 13}, {0x1c, 5},
@@ -1837,7 +2024,7 @@ FMT_FUNC auto is_printable(uint32_t cp) -> bool {
       {0xe1, 2},  {0xe8, 2}, {0xee, 32}, {0xf0, 4}, {0xf8, 2},  {0xf9, 2},
       {0xfa, 2},  {0xfb, 1},
   };
-  static constexpr unsigned char singletons1_lower[] = {
+  static constexpr unsigned char singletons1_lower[] FMT_PROGMEM = {
       0x0c, 0x27, 0x3b, 0x3e, 0x4e, 0x4f, 0x8f, 0x9e, 0x9e, 0x9f, 0x06, 0x07,
       0x09, 0x36, 0x3d, 0x3e, 0x56, 0xf3, 0xd0, 0xd1, 0x04, 0x14, 0x18, 0x36,
       0x37, 0x56, 0x57, 0x7f, 0xaa, 0xae, 0xaf, 0xbd, 0x35, 0xe0, 0x12, 0x87,
@@ -1854,7 +2041,7 @@ FMT_FUNC auto is_printable(uint32_t cp) -> bool {
       0x6b, 0x73, 0x78, 0x7d, 0x7f, 0x8a, 0xa4, 0xaa, 0xaf, 0xb0, 0xc0, 0xd0,
       0xae, 0xaf, 0x79, 0xcc, 0x6e, 0x6f, 0x93,
   };
-  static constexpr unsigned char normal0[] = {
+  static constexpr unsigned char normal0[] FMT_PROGMEM = {
       0x00, 0x20, 0x5f, 0x22, 0x82, 0xdf, 0x04, 0x82, 0x44, 0x08, 0x1b, 0x04,
       0x06, 0x11, 0x81, 0xac, 0x0e, 0x80, 0xab, 0x35, 0x28, 0x0b, 0x80, 0xe0,
       0x03, 0x19, 0x08, 0x01, 0x04, 0x2f, 0x04, 0x34, 0x04, 0x07, 0x03, 0x01,
@@ -1882,7 +2069,7 @@ FMT_FUNC auto is_printable(uint32_t cp) -> bool {
       0xa5, 0x11, 0x81, 0x6d, 0x10, 0x78, 0x28, 0x2a, 0x06, 0x4c, 0x04, 0x80,
       0x8d, 0x04, 0x80, 0xbe, 0x03, 0x1b, 0x03, 0x0f, 0x0d,
   };
-  static constexpr unsigned char normal1[] = {
+  static constexpr unsigned char normal1[] FMT_PROGMEM = {
       0x5e, 0x22, 0x7b, 0x05, 0x03, 0x04, 0x2d, 0x03, 0x66, 0x03, 0x01, 0x2f,
       0x2e, 0x80, 0x82, 0x1d, 0x03, 0x31, 0x0f, 0x1c, 0x04, 0x24, 0x09, 0x1e,
       0x05, 0x2b, 0x05, 0x44, 0x04, 0x0e, 0x2a, 0x80, 0xaa, 0x06, 0x24, 0x04,
@@ -104,6 +104,31 @@
 #  define FMT_USE_RTTI 0
 #endif
 
+// Place lookup tables in program memory on Harvard-architecture targets where
+// constant data is otherwise copied to RAM at startup.
+#ifdef FMT_USE_PROGMEM
+// Use the provided definition.
+#elif defined(__AVR__) || defined(ESP8266)
+#  define FMT_USE_PROGMEM 1
+#else
+#  define FMT_USE_PROGMEM 0
+#endif
+#if FMT_USE_PROGMEM
+#  ifdef __AVR__
+#    include <avr/pgmspace.h>
+#  else
+#    include <pgmspace.h>
+#  endif
+#  define FMT_PROGMEM PROGMEM
+#else
+#  define FMT_PROGMEM
+#endif
+
+// Count heap allocations made through detail::allocator, see get_alloc_stats.
+#ifndef FMT_ALLOC_STATS
+#  define FMT_ALLOC_STATS 0
+#endif
+
 // Visibility when compiled as a shared library/object.
 #if defined(FMT_LIB_EXPORT) || defined(FMT_SHARED)
 #  define FMT_SO_VISIBILITY(value) FMT_VISIBILITY(value)
@@ -737,6 +762,45 @@ using is_double_double = bool_constant<std::numeric_limits<T>::digits == 106>;
 #  define FMT_USE_FULL_CACHE_DRAGONBOX 0
 #endif
 
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/**
+ * Heap usage of {fmt} on the calling thread, see `get_alloc_stats`. The
+ * counters are per thread: memory freed on a thread other than the one that
+ * allocated it is subtracted from the freeing thread's `bytes_in_use`, which
+ * saturates at 0, so `bytes_in_use` of both threads is then inexact.
+ */
+struct alloc_stats {
+  /// Number of allocations.
+  size_t allocations;
+  /// Total number of bytes allocated.
+  size_t bytes;
+  /// Number of bytes currently allocated.
+  size_t bytes_in_use;
+  /// Largest value of `bytes_in_use`.
+  size_t peak_bytes;
+  /// Number of formatting calls whose output was truncated to the budget.
+  size_t truncations;
+};
+
+FMT_END_EXPORT
+
+namespace detail {
+
+inline auto alloc_counters() noexcept -> alloc_stats& {
+  static FMT_THREAD_LOCAL alloc_stats stats = {};
+  return stats;
+}
+
+// The maximum size of the output of a formatting call on this thread or 0 if
+// unlimited.
+inline auto alloc_budget() noexcept -> size_t& {
+  static FMT_THREAD_LOCAL size_t budget = 0;
+  return budget;
+}
+
 // An allocator that uses malloc/free to allow removing dependency on the C++
 // standard libary runtime.
 template <typename T> struct allocator {
@@ -746,19 +810,110 @@ template <typename T> struct allocator {
     FMT_ASSERT(n <= max_value<size_t>() / sizeof(T), "");
     T* p = static_cast<T*>(malloc(n * sizeof(T)));
     if (!p) FMT_THROW(std::bad_alloc());
+#if FMT_ALLOC_STATS
+    auto& stats = alloc_counters();
+    ++stats.allocations;
+    stats.bytes += n * sizeof(T);
+    stats.bytes_in_use += n * sizeof(T);
+    if (stats.bytes_in_use > stats.peak_bytes)
+      stats.peak_bytes = stats.bytes_in_use;
+#endif
     return p;
   }
 
-  void deallocate(T* p, size_t) { free(p); }
+  void deallocate(T* p, size_t n) {
+    free(p);
+#if FMT_ALLOC_STATS
+    auto& in_use = alloc_counters().bytes_in_use;
+    in_use -= min_of(in_use, n * sizeof(T));
+#else
+    ignore_unused(n);
+#endif
+  }
 };
 
 }  // namespace detail
 
 FMT_BEGIN_EXPORT
 
+/// Returns the heap usage of {fmt} on the calling thread. Allocations are only
+/// counted if `FMT_ALLOC_STATS` is enabled.
+inline auto get_alloc_stats() noexcept -> alloc_stats {
+  return detail::alloc_counters();
+}
+
+/// Resets the counters of the calling thread except for the bytes in use.
+inline void reset_alloc_stats() noexcept {
+  auto& stats = detail::alloc_counters();
+  stats = {0, 0, stats.bytes_in_use, stats.bytes_in_use, 0};
+}
+
+/**
+ * Limits the output of each formatting call on the calling thread, such as
+ * `format` or `format_to` into a `memory_buffer`, to `bytes`; longer output is
+ * truncated instead of growing the buffer further. 0 removes the limit.
+ * Returns the previous budget. Calls with a budget stage their output in a
+ * buffer of `FMT_ITERATOR_BUFFER_SIZE` characters on the stack. Compiled
+ * format strings (`FMT_COMPILE`) are not limited.
+ */
+inline auto set_alloc_budget(size_t bytes) noexcept -> size_t {
+  auto& budget = detail::alloc_budget();
+  auto previous = budget;
+  budget = bytes;
+  return previous;
+}
+
+/**
+ * Measures the heap usage of {fmt} between construction and destruction on
+ * the calling thread and optionally applies an allocation budget to it:
+ *
+ *     fmt::alloc_scope scope(256);
+ *     std::string report = fmt::format("{}", readings);
+ *     if (scope.stats().truncations != 0) { ... }
+ */
+class alloc_scope {
+ private:
+  alloc_stats start_;
+  size_t prev_peak_;
+  size_t prev_budget_;
+
+ public:
+  explicit alloc_scope(size_t budget = 0) noexcept
+      : start_(detail::alloc_counters()),
+        prev_peak_(start_.peak_bytes),
+        prev_budget_(budget != 0 ? set_alloc_budget(budget)
+                                 : detail::alloc_budget()) {
+    detail::alloc_counters().peak_bytes = start_.bytes_in_use;
+  }
+  alloc_scope(const alloc_scope&) = delete;
+  void operator=(const alloc_scope&) = delete;
+
+  ~alloc_scope() {
+    auto& stats = detail::alloc_counters();
+    stats.peak_bytes = max_of(stats.peak_bytes, prev_peak_);
+    detail::alloc_budget() = prev_budget_;
+  }
+
+  /// Returns the usage since construction. `bytes_in_use` and `peak_bytes`
+  /// count memory in addition to what was in use at construction.
+  auto stats() const noexcept -> alloc_stats {
+    const auto& now = detail::alloc_counters();
+    return {now.allocations - start_.allocations, now.bytes - start_.bytes,
+            now.bytes_in_use > start_.bytes_in_use
+                ? now.bytes_in_use - start_.bytes_in_use
+                : 0,
+            now.peak_bytes - start_.bytes_in_use,
+            now.truncations - start_.truncations};
+  }
+};
+
+FMT_END_EXPORT
+
+FMT_BEGIN_EXPORT
+
 // The number of characters to store in the basic_memory_buffer object itself
 // to avoid dynamic memory allocation.
-enum { inline_buffer_size = 500 };
+enum { inline_buffer_size = FMT_INLINE_BUFFER_SIZE };
 
 /**
  * A dynamically growing memory buffer for trivially copyable/constructible
@@ -991,12 +1146,24 @@ using uint64_or_128_t = conditional_t<num_bits<T>() <= 64, uint64_t, uint128_t>;
       (factor) * 100000, (factor) * 1000000, (factor) * 10000000, \
       (factor) * 100000000, (factor) * 1000000000
 
-// Converts value in the range [0, 100) to a string.
+// Reads an element of a table declared with FMT_PROGMEM.
+template <typename T> inline auto load_table(const T* p) -> T {
+#if FMT_USE_PROGMEM
+  T value;
+  memcpy_P(static_cast<void*>(&value), p, sizeof(T));
+  return value;
+#else
+  return *p;
+#endif
+}
+
+// Converts value in the range [0, 100) to a string. The result may be in
+// program memory, use copy2_digits to read it.
 // GCC generates slightly better code when value is pointer-size.
 inline auto digits2(size_t value) -> const char* {
   // Align data since unaligned access may be slower when crossing a
   // hardware-specific boundary.
-  alignas(2) static const char data[] =
+  alignas(2) static const char data[] FMT_PROGMEM =
       "0001020304050607080910111213141516171819"
       "2021222324252627282930313233343536373839"
       "4041424344454647484950515253545556575859"
@@ -1005,6 +1172,15 @@ inline auto digits2(size_t value) -> const char* {
   return &data[value * 2];
 }
 
+// Copies the two digits of value in the range [0, 100) to out.
+inline void copy2_digits(char* out, size_t value) {
+#if FMT_USE_PROGMEM
+  memcpy_P(out, digits2(value), 2);
+#else
+  memcpy(out, digits2(value), 2);
+#endif
+}
+
 template <typename Char> constexpr auto getsign(sign s) -> Char {
   return static_cast<char>(((' ' << 24) | ('+' << 16) | ('-' << 8)) >>
                            (static_cast<int>(s) * 8));
@@ -1038,16 +1214,16 @@ inline auto do_count_digits(uint64_t n) -> int {
   // (https://github.com/fmtlib/format-benchmark/blob/master/digits10)
   // but uses smaller tables.
   // Maps bsr(n) to ceil(log10(pow(2, bsr(n) + 1) - 1)).
-  static constexpr uint8_t bsr2log10[] = {
+  static constexpr uint8_t bsr2log10[] FMT_PROGMEM = {
       1,  1,  1,  2,  2,  2,  3,  3,  3,  4,  4,  4,  4,  5,  5,  5,
       6,  6,  6,  7,  7,  7,  7,  8,  8,  8,  9,  9,  9,  10, 10, 10,
       10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 13, 14, 14, 14, 15, 15,
       15, 16, 16, 16, 16, 17, 17, 17, 18, 18, 18, 19, 19, 19, 19, 20};
-  auto t = bsr2log10[FMT_BUILTIN_CLZLL(n | 1) ^ 63];
-  static constexpr const uint64_t zero_or_powers_of_10[] = {
+  auto t = load_table(&bsr2log10[FMT_BUILTIN_CLZLL(n | 1) ^ 63]);
+  static constexpr const uint64_t zero_or_powers_of_10[] FMT_PROGMEM = {
       0, 0, FMT_POWERS_OF_10(1U), FMT_POWERS_OF_10(1000000000ULL),
       10000000000000000000ULL};
-  return t - (n < zero_or_powers_of_10[t]);
+  return t - (n < load_table(&zero_or_powers_of_10[t]));
 }
 #endif
 
@@ -1084,7 +1260,7 @@ FMT_INLINE auto do_count_digits(uint32_t n) -> int {
 // An optimization by Kendall Willets from https://bit.ly/3uOIQrB.
 // This increments the upper 32 bits (log10(T) - 1) when >= T is added.
 #  define FMT_INC(T) (((sizeof(#T) - 1ull) << 32) - T)
-  static constexpr uint64_t table[] = {
+  static constexpr uint64_t table[] FMT_PROGMEM = {
       FMT_INC(0),          FMT_INC(0),          FMT_INC(0),           // 8
       FMT_INC(10),         FMT_INC(10),         FMT_INC(10),          // 64
       FMT_INC(100),        FMT_INC(100),        FMT_INC(100),         // 512
@@ -1097,7 +1273,7 @@ FMT_INLINE auto do_count_digits(uint32_t n) -> int {
       FMT_INC(1000000000), FMT_INC(1000000000), FMT_INC(1000000000),  // 1024M
       FMT_INC(1000000000), FMT_INC(1000000000)                        // 4B
   };
-  auto inc = table[FMT_BUILTIN_CLZ(n | 1) ^ 31];
+  auto inc = load_table(&table[FMT_BUILTIN_CLZ(n | 1) ^ 31]);
   return static_cast<int>((n + inc) >> 32);
 }
 #endif
@@ -1166,7 +1342,7 @@ template <typename Char>
 FMT_CONSTEXPR20 FMT_INLINE void write2digits(Char* out, size_t value) {
   if (!is_constant_evaluated() && std::is_same<Char, char>::value &&
       !FMT_OPTIMIZE_SIZE) {
-    memcpy(out, digits2(value), 2);
+    copy2_digits(reinterpret_cast<char*>(out), value);
     return;
   }
   *out++ = static_cast<Char>('0' + value / 10);
@@ -1503,12 +1679,14 @@ FMT_CONSTEXPR auto write_exponent(int exp, OutputIt out) -> OutputIt {
     return format_decimal<Char>(out, uexp, count_digits(uexp));
   }
   if (uexp >= 100u) {
-    const char* top = digits2(uexp / 100);
+    char top[2];
+    copy2_digits(top, uexp / 100);
     if (uexp >= 1000u) *out++ = static_cast<Char>(top[0]);
     *out++ = static_cast<Char>(top[1]);
     uexp %= 100;
   }
-  const char* d = digits2(uexp);
+  char d[2];
+  copy2_digits(d, uexp);
   *out++ = static_cast<Char>(d[0]);
   *out++ = static_cast<Char>(d[1]);
   return out;
@@ -4186,6 +4364,24 @@ FMT_NODISCARD FMT_INLINE auto formatted_size(const Locale& loc,
 
 FMT_API auto vformat(string_view fmt, format_args args) -> std::string;
 
+#if FMT_USE_SCRATCH_BUFFER
+/// Statistics of the calling thread's `vformat` scratch buffer.
+struct scratch_buffer_stats {
+  /// Capacity retained between calls.
+  size_t capacity;
+  /// Size of the largest output formatted into the buffer.
+  size_t peak_size;
+  /// Number of calls that did not have to grow the buffer.
+  size_t reuse_count;
+};
+
+FMT_API auto get_scratch_buffer_stats() noexcept -> scratch_buffer_stats;
+
+/// Frees the memory retained by the calling thread's scratch buffer and resets
+/// its statistics.
+FMT_API void release_scratch_buffer() noexcept;
+#endif
+
 /**
  * Formats `args` according to specifications in `fmt` and returns the result
  * as a string.
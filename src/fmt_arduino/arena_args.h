@@ -0,0 +1,268 @@
+#pragma once
+
+// A dynamic argument list that copies arguments into a reusable arena.
+//
+// `fmt::dynamic_format_arg_store` allocates a node for every copied argument
+// and frees all of them on `clear()`. `arena_format_arg_store` copies
+// arguments into one block of memory, kept across `clear()` calls, so building
+// an argument list per message stops allocating once the block and the
+// argument arrays have grown to the size of the largest message.
+
+#include "../fmt.h"
+#include <fmt/args.h>
+
+#include <stddef.h>  // max_align_t
+
+#include <new>  // placement new
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+// A bump allocator with an inline first block. Objects are never relocated
+// because formatting arguments point to them. When a block fills up another
+// one is chained; on `clear()` the chain is merged into a single block large
+// enough for everything allocated since the previous `clear()`.
+template <size_t SIZE> class arg_arena {
+ private:
+  struct block {
+    block* next;
+    size_t capacity;
+  };
+
+  struct destructor {
+    void (*destroy)(void* object);
+    void* object;
+    destructor* next;
+  };
+
+  enum : size_t { header_size = (sizeof(block) + alignof(max_align_t) - 1) /
+                                alignof(max_align_t) * alignof(max_align_t) };
+
+  alignas(max_align_t) unsigned char store_[SIZE];
+  unsigned char* data_ = store_;
+  size_t capacity_ = SIZE;
+  size_t size_ = 0;
+  block* heap_ = nullptr;      // The heap block backing data_ if any.
+  block* overflow_ = nullptr;  // Blocks chained since the last clear().
+  size_t overflow_size_ = 0;
+  destructor* destructors_ = nullptr;
+
+  static auto new_block(size_t capacity) -> block* {
+    auto b = reinterpret_cast<block*>(
+        allocator<unsigned char>().allocate(header_size + capacity));
+    b->next = nullptr;
+    b->capacity = capacity;
+    return b;
+  }
+
+  static void free_block(block* b) {
+    allocator<unsigned char>().deallocate(reinterpret_cast<unsigned char*>(b),
+                                          header_size + b->capacity);
+  }
+
+  static auto block_data(block* b) -> unsigned char* {
+    return reinterpret_cast<unsigned char*>(b) + header_size;
+  }
+
+  template <typename T> static void destroy(void* object) {
+    static_cast<T*>(object)->~T();
+  }
+
+ public:
+  arg_arena() = default;
+  arg_arena(const arg_arena&) = delete;
+  void operator=(const arg_arena&) = delete;
+  ~arg_arena() {
+    clear();
+    if (heap_) free_block(heap_);
+  }
+
+  auto allocate(size_t size, size_t align) -> void* {
+    size_t offset = (size_ + align - 1) & ~(align - 1);
+    if (offset + size > capacity_) {
+      // Chain a new block keeping the current one alive.
+      size_t capacity =
+          max_of<size_t>(capacity_ + capacity_ / 2, size + align);
+      auto b = new_block(capacity);
+      b->next = overflow_;
+      overflow_ = b;
+      overflow_size_ += capacity_;
+      data_ = block_data(b);
+      capacity_ = capacity;
+      offset = 0;
+    }
+    size_ = offset + size;
+    return data_ + offset;
+  }
+
+  template <typename T, typename Arg> auto push(const Arg& arg) -> const T& {
+    auto object = new (allocate(sizeof(T), alignof(T))) T(arg);
+    if (!std::is_trivially_destructible<T>::value) {
+      auto d = static_cast<destructor*>(
+          allocate(sizeof(destructor), alignof(destructor)));
+      *d = {destroy<T>, object, destructors_};
+      destructors_ = d;
+    }
+    return *object;
+  }
+
+  template <typename Char>
+  auto push_string(basic_string_view<Char> s) -> const Char* {
+    auto p = static_cast<Char*>(allocate((s.size() + 1) * sizeof(Char),
+                                         alignof(Char)));
+    copy<Char>(s.begin(), s.end(), p);
+    p[s.size()] = Char();
+    return p;
+  }
+
+  void clear() {
+    for (auto d = destructors_; d; d = d->next) d->destroy(d->object);
+    destructors_ = nullptr;
+    size_ = 0;
+    if (!overflow_) return;
+    size_t capacity = overflow_size_ + capacity_;
+    while (overflow_) {
+      auto next = overflow_->next;
+      free_block(overflow_);
+      overflow_ = next;
+    }
+    overflow_size_ = 0;
+    if (heap_) free_block(heap_);
+    heap_ = new_block(capacity);
+    data_ = block_data(heap_);
+    capacity_ = capacity;
+  }
+
+  /// Returns the capacity of the current block.
+  auto capacity() const -> size_t { return capacity_; }
+};
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/**
+ * A dynamic list of formatting arguments like `dynamic_format_arg_store`
+ * whose copies of arguments live in an arena of `ARENA_SIZE` bytes stored in
+ * the object and whose argument arrays have room for `NUM_ARGS` arguments
+ * before they allocate. Both grow when needed and keep their capacity on
+ * `clear()` so the store can be reused between messages:
+ *
+ *     static fmt::arena_format_arg_store<fmt::format_context> store;
+ *     store.clear();
+ *     store.push_back(fmt::arg("topic", topic));
+ *     store.push_back(fmt::arg("value", value));
+ *     std::string s = fmt::vformat("{topic}={value}", store);
+ */
+template <typename Context, size_t ARENA_SIZE = 256, size_t NUM_ARGS = 8>
+class arena_format_arg_store {
+ private:
+  using char_type = typename Context::char_type;
+
+  // Unlike in dynamic_format_arg_store the stored rather than the mapped type
+  // is checked: with FMT_BUILTIN_TYPES disabled arguments other than int are
+  // referenced by pointer and have to outlive the call to push_back.
+  template <typename T> struct need_copy {
+    static constexpr detail::type stored_type =
+        detail::stored_type_constant<T, Context>::value;
+
+    enum {
+      value = !detail::is_reference_wrapper<T>::value &&
+              (stored_type == detail::type::cstring_type ||
+               stored_type == detail::type::string_type ||
+               stored_type == detail::type::custom_type)
+    };
+  };
+
+  template <typename T>
+  using is_string_view =
+      bool_constant<std::is_same<T, basic_string_view<char_type>>::value ||
+                    std::is_same<T, detail::std_string_view<char_type>>::value>;
+
+  // Strings are copied as characters, everything else including string views
+  // as an object.
+  template <typename T>
+  using is_string =
+      bool_constant<detail::has_to_string_view<T>::value &&
+                    !is_string_view<T>::value &&
+                    !detail::is_reference_wrapper<T>::value>;
+
+  // data_[0] holds the named argument table, arguments start at data_[1].
+  basic_memory_buffer<basic_format_arg<Context>, NUM_ARGS + 1> data_;
+  basic_memory_buffer<detail::named_arg_info<char_type>, NUM_ARGS>
+      named_info_;
+  detail::arg_arena<ARENA_SIZE> arena_;
+
+  template <typename T, FMT_ENABLE_IF(is_string<T>::value)>
+  auto copy(const T& arg) -> const basic_string_view<char_type>& {
+    auto sv = detail::to_string_view(arg);
+    return arena_.template push<basic_string_view<char_type>>(
+        basic_string_view<char_type>(arena_.push_string(sv), sv.size()));
+  }
+  template <typename T, FMT_ENABLE_IF(!is_string<T>::value)>
+  auto copy(const T& arg) -> const T& {
+    return arena_.template push<T>(arg);
+  }
+
+  template <typename T> void emplace_arg(const T& arg) {
+    data_.push_back(basic_format_arg<Context>(arg));
+  }
+
+ public:
+  arena_format_arg_store() { data_.push_back(basic_format_arg<Context>()); }
+
+  operator basic_format_args<Context>() const {
+    return basic_format_args<Context>(data_.data() + 1,
+                                      static_cast<int>(data_.size() - 1),
+                                      named_info_.size() != 0);
+  }
+
+  /**
+   * Adds an argument into the store. Strings and custom types are copied into
+   * the arena unless passed with `std::cref`; string views are copied without
+   * the characters they refer to.
+   */
+  template <typename T> void push_back(const T& arg) {
+    if (detail::const_check(need_copy<T>::value))
+      emplace_arg(copy(arg));
+    else
+      emplace_arg(detail::unwrap(arg));
+  }
+
+  template <typename T> void push_back(std::reference_wrapper<T> arg) {
+    static_assert(
+        need_copy<T>::value,
+        "objects of built-in types and string views are always copied");
+    emplace_arg(arg.get());
+  }
+
+  /// Adds a named argument. The name is always copied into the arena.
+  template <typename T>
+  void push_back(const detail::named_arg<char_type, T>& arg) {
+    const char_type* name =
+        arena_.push_string(detail::to_string_view(arg.name));
+    named_info_.push_back({name, static_cast<int>(data_.size() - 1)});
+    if (detail::const_check(need_copy<T>::value))
+      emplace_arg(copy(arg.value));
+    else
+      emplace_arg(detail::unwrap(arg.value));
+    data_[0] =
+        basic_format_arg<Context>(named_info_.data(), named_info_.size());
+  }
+
+  /// Removes all arguments keeping the memory for reuse.
+  void clear() {
+    data_.resize(1);
+    named_info_.clear();
+    arena_.clear();
+  }
+
+  /// Returns the number of arguments in the store.
+  auto size() const noexcept -> size_t { return data_.size() - 1; }
+
+  /// Returns the number of bytes the arena can hold without allocating.
+  auto arena_capacity() const noexcept -> size_t { return arena_.capacity(); }
+};
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
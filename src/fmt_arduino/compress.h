@@ -0,0 +1,251 @@
+#pragma once
+
+// LZSS compression of formatted output while it is written.
+//
+// Log lines are repetitive: timestamps, levels and message templates repeat
+// with a few changing fields. `fmt::lzss_sink` wraps a sink (see sink.h) and
+// compresses the output with LZSS using a small sliding window, in the spirit
+// of heatshrink: it needs about 2 << WINDOW_BITS bytes of RAM, no heap and no
+// tables. `fmt::lzss_decoder` is the matching decompressor; it needs
+// 1 << WINDOW_BITS bytes of RAM and can run on the board or on the host.
+//
+// The compressed data is a stream of bits, most significant bit first:
+//
+//   1 + 8 bits:                    a literal byte
+//   0 + WINDOW_BITS + COUNT_BITS:  copy `count + 1` bytes starting `offset + 1`
+//                                  bytes back in the output
+//
+// The last byte is padded with zero bits, which is shorter than any token.
+
+#include "sink.h"
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+template <unsigned WINDOW_BITS, unsigned COUNT_BITS> struct lzss_params {
+  static_assert(WINDOW_BITS >= 4 && WINDOW_BITS <= 14, "invalid window size");
+  static_assert(COUNT_BITS >= 3 && COUNT_BITS < WINDOW_BITS &&
+                    WINDOW_BITS + COUNT_BITS <= 23,
+                "invalid count size");
+
+  enum : size_t {
+    window_size = size_t(1) << WINDOW_BITS,
+    max_count = size_t(1) << COUNT_BITS,
+    backref_bits = 1 + WINDOW_BITS + COUNT_BITS,
+    // The shortest match that is smaller than the literals it replaces.
+    min_count = backref_bits / 9 + 1,
+    out_size = 32
+  };
+};
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/**
+ * A sink that compresses the output and writes it to `Sink`. Call `finish()`
+ * after the last output to write the pending data:
+ *
+ *     auto out = fmt::compressed(log_file);
+ *     fmt::format_to(out, "{} {} {}\n", millis(), level, message);
+ *     out.finish();
+ *
+ * A window of 2^WINDOW_BITS bytes is searched for matches of up to
+ * 2^COUNT_BITS bytes. A larger window compresses better but the encoder is
+ * slower and needs more RAM.
+ */
+template <typename Sink, unsigned WINDOW_BITS = 8, unsigned COUNT_BITS = 4>
+class lzss_sink {
+ private:
+  using params = detail::lzss_params<WINDOW_BITS, COUNT_BITS>;
+  enum : size_t { window_size = params::window_size };
+
+  Sink& sink_;
+  // Up to window_size bytes of history followed by input not encoded yet.
+  unsigned char data_[2 * window_size];
+  size_t size_ = 0;
+  size_t pos_ = 0;  // The position of the next byte to encode.
+  uint32_t bits_ = 0;
+  unsigned num_bits_ = 0;
+  unsigned char out_[params::out_size];
+  size_t out_size_ = 0;
+  size_t total_in_ = 0;
+  size_t total_out_ = 0;
+
+  void put_bits(uint32_t value, unsigned n) {
+    bits_ = bits_ << n | value;
+    num_bits_ += n;
+    while (num_bits_ >= 8) {
+      num_bits_ -= 8;
+      put_byte(static_cast<unsigned char>(bits_ >> num_bits_));
+    }
+    bits_ &= (uint32_t(1) << num_bits_) - 1;
+  }
+
+  void put_byte(unsigned char c) {
+    if (out_size_ == sizeof(out_)) flush_output();
+    out_[out_size_++] = c;
+  }
+
+  void flush_output() {
+    detail::write_to_sink(sink_, reinterpret_cast<const char*>(out_),
+                          out_size_);
+    total_out_ += out_size_;
+    out_size_ = 0;
+  }
+
+  // Encodes the input up to `end`, looking ahead at most up to `size_`.
+  void encode(size_t end) {
+    while (pos_ < end) {
+      size_t max_count =
+          min_of<size_t>(params::max_count, size_ - pos_);
+      size_t start = pos_ > window_size ? pos_ - window_size : 0;
+      size_t best_count = 0, best_pos = 0;
+      for (size_t i = pos_; i-- > start;) {
+        if (data_[i] != data_[pos_]) continue;
+        size_t count = 1;
+        while (count < max_count && data_[i + count] == data_[pos_ + count])
+          ++count;
+        if (count > best_count) {
+          best_count = count;
+          best_pos = i;
+          if (count == max_count) break;
+        }
+      }
+      if (best_count >= params::min_count) {
+        put_bits(0, 1);
+        put_bits(static_cast<uint32_t>(pos_ - best_pos - 1), WINDOW_BITS);
+        put_bits(static_cast<uint32_t>(best_count - 1), COUNT_BITS);
+        pos_ += best_count;
+      } else {
+        put_bits(0x100 | data_[pos_], 9);
+        ++pos_;
+      }
+    }
+  }
+
+  // Drops the history that is out of the window.
+  void shift() {
+    if (pos_ <= window_size) return;
+    size_t n = pos_ - window_size;
+    memmove(data_, data_ + n, size_ - n);
+    size_ -= n;
+    pos_ -= n;
+  }
+
+ public:
+  explicit lzss_sink(Sink& sink) : sink_(sink) {}
+
+  auto write(const char* data, size_t size) -> size_t {
+    total_in_ += size;
+    for (size_t n = size; n != 0;) {
+      size_t count = min_of(n, sizeof(data_) - size_);
+      memcpy(data_ + size_, data, count);
+      size_ += count;
+      data += count;
+      n -= count;
+      if (size_ == sizeof(data_)) {
+        // Keep a full lookahead for the next write.
+        encode(size_ - params::max_count);
+        shift();
+      }
+    }
+    return size;
+  }
+
+  /// Encodes the pending input, pads the last byte and writes everything to
+  /// the sink. Later output starts a new stream with an empty window.
+  void finish() {
+    encode(size_);
+    if (num_bits_ != 0) put_bits(0, 8 - num_bits_);
+    flush_output();
+    size_ = pos_ = 0;
+  }
+
+  /// Returns the number of bytes written to this sink.
+  auto bytes_in() const -> size_t { return total_in_; }
+
+  /// Returns the number of compressed bytes written to the underlying sink.
+  auto bytes_out() const -> size_t { return total_out_; }
+};
+
+/// Returns an `lzss_sink` with the default parameters that writes to `sink`.
+template <typename Sink> auto compressed(Sink& sink) -> lzss_sink<Sink> {
+  return lzss_sink<Sink>(sink);
+}
+
+/**
+ * Decompresses data produced by `lzss_sink` with the same parameters and
+ * writes it to `Sink`. It is a sink itself, so compressed data can be passed
+ * to it in blocks of any size. Call `finish()` after the last block.
+ */
+template <typename Sink, unsigned WINDOW_BITS = 8, unsigned COUNT_BITS = 4>
+class lzss_decoder {
+ private:
+  using params = detail::lzss_params<WINDOW_BITS, COUNT_BITS>;
+  enum : size_t { window_size = params::window_size };
+
+  Sink& sink_;
+  unsigned char window_[window_size];
+  size_t pos_ = 0;  // The position of the next byte in window_.
+  uint32_t bits_ = 0;
+  unsigned num_bits_ = 0;
+  char out_[params::out_size];
+  size_t out_size_ = 0;
+
+  void put(unsigned char c) {
+    window_[pos_] = c;
+    pos_ = (pos_ + 1) & (window_size - 1);
+    if (out_size_ == sizeof(out_)) flush_output();
+    out_[out_size_++] = static_cast<char>(c);
+  }
+
+  void flush_output() {
+    detail::write_to_sink(sink_, out_, out_size_);
+    out_size_ = 0;
+  }
+
+  auto take_bits(unsigned n) -> uint32_t {
+    num_bits_ -= n;
+    auto value = bits_ >> num_bits_ & ((uint32_t(1) << n) - 1);
+    bits_ &= (uint32_t(1) << num_bits_) - 1;
+    return value;
+  }
+
+ public:
+  explicit lzss_decoder(Sink& sink) : sink_(sink) {}
+
+  auto write(const char* data, size_t size) -> size_t {
+    for (size_t i = 0; i < size; ++i) {
+      bits_ = bits_ << 8 | static_cast<unsigned char>(data[i]);
+      num_bits_ += 8;
+      for (;;) {
+        if (num_bits_ == 0) break;
+        bool literal = (bits_ >> (num_bits_ - 1) & 1) != 0;
+        if (num_bits_ < (literal ? 9u : unsigned(params::backref_bits))) break;
+        take_bits(1);
+        if (literal) {
+          put(static_cast<unsigned char>(take_bits(8)));
+          continue;
+        }
+        size_t offset = take_bits(WINDOW_BITS) + 1;
+        size_t count = take_bits(COUNT_BITS) + 1;
+        for (size_t j = 0; j < count; ++j)
+          put(window_[(pos_ - offset) & (window_size - 1)]);
+      }
+    }
+    return size;
+  }
+
+  /// Writes the pending output to the sink and discards the padding bits of
+  /// the last byte. Later input starts a new stream with an empty window.
+  void finish() {
+    flush_output();
+    bits_ = 0;
+    num_bits_ = 0;
+    pos_ = 0;
+  }
+};
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
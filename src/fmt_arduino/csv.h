@@ -0,0 +1,134 @@
+#pragma once
+
+// Writing CSV rows with a fixed layout.
+//
+// Data loggers write many rows of the same shape. `fmt::csv_row` takes one
+// format string per column, ideally compiled with `FMT_COMPILE`, and appends
+// rows to a memory buffer that is reused between rows:
+//
+//     auto row = fmt::csv_row(FMT_COMPILE("{}"), FMT_COMPILE("{:.2f}"),
+//                             FMT_COMPILE("{}"));
+//     fmt::memory_buffer buf;
+//     row.format_to(buf, millis(), temperature, name);
+//     log_file.write(buf.data(), buf.size());
+//     buf.clear();
+//
+// Columns are separated with ',' and rows end with "\r\n" as in RFC 4180;
+// both can be changed. Fields are quoted, with quotes doubled, only if they
+// contain the separator, a quote or a line break, whatever their type or
+// format string. The check looks at a machine word at a time, so plain text
+// costs little more than copying it.
+//
+// The buffer is reserved once per row for the longest row written so far, so
+// it normally grows only while the first rows are written.
+
+#include "escape.h"
+
+#pragma push_macro("F")
+#pragma push_macro("B1")
+#undef B1
+#undef F
+#include <fmt/compile.h>
+#pragma pop_macro("F")
+#pragma pop_macro("B1")
+
+#include <tuple>
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+// Returns true if `field` contains `sep`, '"', '\r' or '\n'.
+inline auto csv_needs_quotes(string_view field, char sep) -> bool {
+  auto s = static_cast<unsigned char>(sep);
+  return find_special(
+             field,
+             [=](size_t w) {
+               return has_byte(w, s) || has_byte(w, '"') ||
+                      has_byte(w, '\n') || has_byte(w, '\r');
+             },
+             [=](char c) {
+               return c == sep || c == '"' || c == '\n' || c == '\r';
+             }) != field.end();
+}
+
+// Quotes the field that starts at `start` and extends to the end of `buf`,
+// doubling quotes.
+inline void csv_quote(buffer<char>& buf, size_t start) {
+  quote_in_place(
+      buf, start, [](char c) -> size_t { return c == '"' ? 2 : 1; },
+      [](char, char* out) { out[0] = out[1] = '"'; });
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// A CSV row layout with one format string per column, see `fmt::csv_row`.
+template <typename... Formats> class csv_row_format {
+ private:
+  std::tuple<Formats...> formats_;
+  char separator_ = ',';
+  string_view line_end_ = "\r\n";
+  size_t size_hint_ = 0;
+
+  template <typename Format, typename T>
+  void write_field(detail::buffer<char>& buf, bool first, const Format& fmt,
+                   const T& value) {
+    if (!first) buf.push_back(separator_);
+    size_t start = buf.size();
+    fmt::format_to(appender(buf), fmt, value);
+    auto field = string_view(buf.data() + start, buf.size() - start);
+    if (detail::csv_needs_quotes(field, separator_))
+      detail::csv_quote(buf, start);
+  }
+
+  template <size_t... Is, typename... T>
+  void write_fields(detail::buffer<char>& buf, detail::index_sequence<Is...>,
+                    const T&... values) {
+    int dummy[] = {
+        0, (write_field(buf, Is == 0, std::get<Is>(formats_), values), 0)...};
+    detail::ignore_unused(dummy);
+  }
+
+ public:
+  explicit csv_row_format(Formats... formats) : formats_(formats...) {}
+
+  /// Sets the column separator, e.g. ';' or '\t'.
+  auto separator(char sep) -> csv_row_format& {
+    separator_ = sep;
+    return *this;
+  }
+
+  /// Sets the string written after each row, e.g. "\n".
+  auto line_end(string_view s) -> csv_row_format& {
+    line_end_ = s;
+    return *this;
+  }
+
+  /// Appends a row with `values` formatted according to the layout to `buf`.
+  template <size_t SIZE, typename... T>
+  void format_to(basic_memory_buffer<char, SIZE>& buf, const T&... values) {
+    static_assert(sizeof...(T) == sizeof...(Formats),
+                  "the number of values doesn't match the number of columns");
+    size_t start = buf.size();
+    buf.reserve(start + size_hint_);
+    write_fields(buf, detail::make_index_sequence<sizeof...(T)>(), values...);
+    buf.append(line_end_.begin(), line_end_.end());
+    size_hint_ = max_of(size_hint_, buf.size() - start);
+  }
+};
+
+/**
+ * Returns a CSV row layout with the format strings of the columns:
+ *
+ *     auto row = fmt::csv_row(FMT_COMPILE("{}"), FMT_COMPILE("{:.3f}"));
+ *     row.format_to(buf, id, value);
+ */
+template <typename... Formats>
+auto csv_row(Formats... formats) -> csv_row_format<Formats...> {
+  static_assert(sizeof...(Formats) > 0, "a row needs at least one column");
+  return csv_row_format<Formats...>(formats...);
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
@@ -0,0 +1,243 @@
+#pragma once
+
+// Base64 and hex encoding of binary data as format arguments.
+//
+// Binary payloads in JSON or MQTT messages are usually encoded into a
+// separate buffer and then formatted as a string. `fmt::base64`,
+// `fmt::base64url` and `fmt::hex` return views that are encoded straight into
+// the output:
+//
+//     fmt::format_to(out, R"({{"id":{},"key":"{}"}})", id, fmt::base64(key));
+//
+// Encoding is table driven, with the tables in flash on AVR and ESP8266. The
+// encoded size is known in advance, so when the output is a memory buffer the
+// data is encoded in place, otherwise in blocks of 64 characters on the stack.
+// Width, fill and alignment are supported; `{:X}` formats hex in upper case.
+
+#include "../fmt.h"
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+// The base64 alphabet followed by the URL and filename safe alphabet.
+inline auto base64_alphabet(bool url) -> const char* {
+  static const char data[] FMT_PROGMEM =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  return url ? data + 64 : data;
+}
+
+inline auto hex_digits(bool upper) -> const char* {
+  static const char data[] FMT_PROGMEM = "0123456789abcdef0123456789ABCDEF";
+  return upper ? data + 16 : data;
+}
+
+inline auto base64_size(size_t size, bool pad) -> size_t {
+  size_t rem = size % 3;
+  return size / 3 * 4 + (rem == 0 ? 0 : pad ? 4 : rem + 1);
+}
+
+// Encodes `size` bytes to base64. Only the last block may be partial.
+inline auto encode_base64(char* out, const unsigned char* in, size_t size,
+                          bool url, bool pad) -> char* {
+  auto t = base64_alphabet(url);
+  for (; size >= 3; in += 3, size -= 3) {
+    uint32_t v = uint32_t(in[0]) << 16 | uint32_t(in[1]) << 8 | in[2];
+    *out++ = load_table(t + (v >> 18));
+    *out++ = load_table(t + (v >> 12 & 63));
+    *out++ = load_table(t + (v >> 6 & 63));
+    *out++ = load_table(t + (v & 63));
+  }
+  if (size == 0) return out;
+  uint32_t v = uint32_t(in[0]) << 16 | (size == 2 ? uint32_t(in[1]) << 8 : 0);
+  *out++ = load_table(t + (v >> 18));
+  *out++ = load_table(t + (v >> 12 & 63));
+  if (size == 2) *out++ = load_table(t + (v >> 6 & 63));
+  if (pad) {
+    *out++ = '=';
+    if (size == 1) *out++ = '=';
+  }
+  return out;
+}
+
+inline auto encode_hex(char* out, const unsigned char* in, size_t size,
+                       bool upper) -> char* {
+  auto t = hex_digits(upper);
+  for (size_t i = 0; i < size; ++i) {
+    *out++ = load_table(t + (in[i] >> 4));
+    *out++ = load_table(t + (in[i] & 15));
+  }
+  return out;
+}
+
+// Writes `size` bytes encoded by `encode(out, in, n)` in place if possible
+// and in blocks of `block_size` input bytes otherwise.
+template <size_t block_size, typename Encode>
+auto write_encoded(appender out, const unsigned char* data, size_t size,
+                   size_t encoded_size, Encode encode) -> appender {
+  if (char* p = to_pointer<char>(out, encoded_size)) {
+    encode(p, data, size);
+    return out;
+  }
+  char block[64];
+  for (size_t i = 0; i < size; i += block_size) {
+    auto end = encode(block, data + i, min_of(block_size, size - i));
+    out = copy<char>(block, end, out);
+  }
+  return out;
+}
+
+// Parses string specs optionally followed by a presentation type in `types`.
+FMT_CONSTEXPR inline auto parse_encoding_specs(format_parse_context& ctx,
+                                               dynamic_format_specs<>& specs,
+                                               const char* types, char& type)
+    -> const char* {
+  auto end = ctx.begin();
+  for (int depth = 0; end != ctx.end() && (depth > 0 || *end != '}'); ++end) {
+    if (*end == '{')
+      ++depth;
+    else if (*end == '}')
+      --depth;
+  }
+  if (end != ctx.begin()) {
+    for (auto t = types; *t; ++t) {
+      if (end[-1] != *t) continue;
+      type = *t;
+      if (parse_format_specs(ctx.begin(), end - 1, specs, ctx,
+                             type::string_type) != end - 1)
+        report_error("invalid format specifier");
+      return end;
+    }
+  }
+  return parse_format_specs(ctx.begin(), ctx.end(), specs, ctx,
+                            type::string_type);
+}
+
+template <typename R>
+using byte_range_t = enable_if_t<
+    sizeof(*std::declval<const R&>().data()) == 1 &&
+        std::is_convertible<decltype(std::declval<const R&>().size()),
+                            size_t>::value,
+    int>;
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// A view of binary data formatted as base64, see `fmt::base64`.
+struct base64_view {
+  const unsigned char* data;
+  size_t size;
+  bool url;
+};
+
+/// A view of binary data formatted as hex digits, see `fmt::hex`.
+struct hex_view {
+  const unsigned char* data;
+  size_t size;
+};
+
+/// Returns a view that formats `size` bytes at `data` as base64 with padding.
+inline auto base64(const void* data, size_t size) -> base64_view {
+  return {static_cast<const unsigned char*>(data), size, false};
+}
+
+/// Returns a view that formats the bytes of `r`, e.g. a `std::vector<uint8_t>`
+/// or a `std::array<char, N>`, as base64 with padding.
+template <typename R, detail::byte_range_t<R> = 0>
+auto base64(const R& r) -> base64_view {
+  return base64(r.data(), r.size());
+}
+
+template <size_t N> auto base64(const uint8_t (&a)[N]) -> base64_view {
+  return base64(a, N);
+}
+
+/// Returns a view that formats `size` bytes at `data` as base64url (RFC 4648
+/// section 5) without padding.
+inline auto base64url(const void* data, size_t size) -> base64_view {
+  return {static_cast<const unsigned char*>(data), size, true};
+}
+
+template <typename R, detail::byte_range_t<R> = 0>
+auto base64url(const R& r) -> base64_view {
+  return base64url(r.data(), r.size());
+}
+
+template <size_t N> auto base64url(const uint8_t (&a)[N]) -> base64_view {
+  return base64url(a, N);
+}
+
+/// Returns a view that formats `size` bytes at `data` as two hex digits each.
+inline auto hex(const void* data, size_t size) -> hex_view {
+  return {static_cast<const unsigned char*>(data), size};
+}
+
+template <typename R, detail::byte_range_t<R> = 0>
+auto hex(const R& r) -> hex_view {
+  return hex(r.data(), r.size());
+}
+
+template <size_t N> auto hex(const uint8_t (&a)[N]) -> hex_view {
+  return hex(a, N);
+}
+
+template <> struct formatter<base64_view> {
+ private:
+  detail::dynamic_format_specs<> specs_;
+
+ public:
+  FMT_CONSTEXPR auto parse(format_parse_context& ctx) -> const char* {
+    char type = 0;
+    return detail::parse_encoding_specs(ctx, specs_, "", type);
+  }
+
+  auto format(const base64_view& v, format_context& ctx) const
+      -> format_context::iterator {
+    auto specs = specs_;
+    detail::handle_dynamic_spec(specs.dynamic_width(), specs.width,
+                                specs.width_ref, ctx);
+    bool pad = !v.url;
+    size_t size = detail::base64_size(v.size, pad);
+    auto encode = [&](char* out, const unsigned char* in, size_t n) {
+      return detail::encode_base64(out, in, n, v.url, pad);
+    };
+    return detail::write_padded<char>(
+        ctx.out(), specs, size, size, [&](appender it) {
+          return detail::write_encoded<48>(it, v.data, v.size, size, encode);
+        });
+  }
+};
+
+template <> struct formatter<hex_view> {
+ private:
+  detail::dynamic_format_specs<> specs_;
+  bool upper_ = false;
+
+ public:
+  FMT_CONSTEXPR auto parse(format_parse_context& ctx) -> const char* {
+    char type = 0;
+    auto it = detail::parse_encoding_specs(ctx, specs_, "xX", type);
+    upper_ = type == 'X';
+    return it;
+  }
+
+  auto format(const hex_view& v, format_context& ctx) const
+      -> format_context::iterator {
+    auto specs = specs_;
+    detail::handle_dynamic_spec(specs.dynamic_width(), specs.width,
+                                specs.width_ref, ctx);
+    size_t size = v.size * 2;
+    bool upper = upper_;
+    auto encode = [=](char* out, const unsigned char* in, size_t n) {
+      return detail::encode_hex(out, in, n, upper);
+    };
+    return detail::write_padded<char>(
+        ctx.out(), specs, size, size, [&](appender it) {
+          return detail::write_encoded<32>(it, v.data, v.size, size, encode);
+        });
+  }
+};
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
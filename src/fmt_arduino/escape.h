@@ -0,0 +1,78 @@
+#pragma once
+
+// Helpers shared by the JSON, CSV and logfmt writers.
+//
+// Text is checked for characters that must be escaped or quoted a machine
+// word at a time, so plain text costs little more than copying it. Fields that
+// do need quotes are formatted into the buffer first and then quoted in place.
+
+#include "../fmt.h"
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+enum : size_t {
+  word_ones = max_value<size_t>() / 0xff,  // 0x0101...
+  word_high = word_ones * 0x80
+};
+
+// Returns true if any byte of `w` is less than `n`, which must be at most 0x80.
+inline auto has_byte_less(size_t w, unsigned char n) -> bool {
+  return ((w - word_ones * n) & ~w & word_high) != 0;
+}
+
+// Returns true if any byte of `w` is `c`.
+inline auto has_byte(size_t w, unsigned char c) -> bool {
+  return has_byte_less(w ^ (word_ones * c), 1);
+}
+
+// Returns a pointer to the first character in `s` for which `is_special(c)` is
+// true or `s.end()` if there is none. `has_special(w)` must be true for every
+// word that contains such a character.
+template <typename WordPred, typename CharPred>
+auto find_special(string_view s, WordPred has_special, CharPred is_special)
+    -> const char* {
+  auto begin = s.begin(), end = s.end();
+  while (to_unsigned(end - begin) >= sizeof(size_t)) {
+    size_t w;
+    memcpy(&w, begin, sizeof(w));
+    if (has_special(w)) break;
+    begin += sizeof(size_t);
+  }
+  for (; begin != end; ++begin) {
+    if (is_special(*begin)) return begin;
+  }
+  return end;
+}
+
+// Encloses the text that starts at `start` and extends to the end of `buf` in
+// double quotes. A character `c` takes `escape_size(c)` characters in the
+// result; if that is more than one, `write_escape(c, p)` writes them to `p`.
+// The text is moved from the back, so no second buffer is needed. The text is
+// left unquoted if `buf` can't grow.
+template <typename EscapeSize, typename WriteEscape>
+void quote_in_place(buffer<char>& buf, size_t start, EscapeSize escape_size,
+                    WriteEscape write_escape) {
+  size_t size = buf.size();
+  size_t quoted_size = size + 2;
+  for (size_t i = start; i < size; ++i)
+    quoted_size += escape_size(buf[i]) - 1;
+  buf.try_resize(quoted_size);
+  if (buf.size() != quoted_size) return;
+  char* data = buf.data();
+  size_t out = quoted_size - 1;
+  data[out] = '"';
+  for (size_t i = size; i-- > start;) {
+    char c = data[i];
+    size_t n = escape_size(c);
+    out -= n;
+    if (n == 1)
+      data[out] = c;
+    else
+      write_escape(c, data + out);
+  }
+  data[start] = '"';
+}
+
+}  // namespace detail
+FMT_END_NAMESPACE
@@ -0,0 +1,220 @@
+#pragma once
+
+// Format strings and string arguments stored in flash (`F()` / `PROGMEM`).
+//
+// On AVR and ESP8266 string literals are copied to RAM at startup unless they
+// are placed in flash with `F()` or `PROGMEM`, and flash has to be read with
+// `pgm_read_byte`. Format strings passed as `F("...")` are read from flash one
+// character at a time: literal text is written straight to the output and
+// only one replacement field at a time is copied to a small stack buffer to be
+// parsed. Flash strings can be passed as arguments wrapped in `fmt::flash`.
+//
+// Format strings in flash are not checked at compile time; errors are
+// reported at runtime like for `fmt::runtime`.
+
+#include "../fmt.h"
+
+#if defined(__AVR__)
+#  include <avr/pgmspace.h>
+#elif defined(ESP8266) || defined(ESP32)
+#  include <pgmspace.h>
+#endif
+
+// Reads a byte from flash. Targets with a unified address space read it
+// directly.
+#ifndef FMT_PGM_READ_BYTE
+#  ifdef pgm_read_byte
+#    define FMT_PGM_READ_BYTE(p) pgm_read_byte(p)
+#  else
+#    define FMT_PGM_READ_BYTE(p) (*reinterpret_cast<const unsigned char*>(p))
+#  endif
+#endif
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+inline auto read_flash(const char* p) -> char {
+  return static_cast<char>(FMT_PGM_READ_BYTE(p));
+}
+
+// The maximum size of a replacement field, including the braces, in a format
+// string stored in flash.
+enum { max_flash_field_size = 64 };
+
+// Formats a format string stored in flash. Each replacement field is copied
+// to RAM and formatted on its own, so automatic argument ids are replaced with
+// explicit ones while copying.
+inline void vformat_flash_to(buffer<char>& buf, const char* fmt,
+                             format_args args) {
+  char field[max_flash_field_size];
+  size_t size = 0;
+  auto put = [&](char c) {
+    if (size == max_flash_field_size)
+      report_error("replacement field too long");
+    field[size++] = c;
+  };
+  int next_arg_id = 0;  // -1 after a manual argument id.
+  for (;;) {
+    char c = read_flash(fmt++);
+    if (c == '\0') return;
+    if (c == '}') {
+      if (read_flash(fmt++) != '}')
+        report_error("unmatched '}' in format string");
+      buf.push_back('}');
+      continue;
+    }
+    if (c != '{') {
+      buf.push_back(c);
+      continue;
+    }
+    if (read_flash(fmt) == '{') {
+      ++fmt;
+      buf.push_back('{');
+      continue;
+    }
+    size = 0;
+    put('{');
+    for (int depth = 1; depth > 0;) {
+      char prev = c;
+      c = read_flash(fmt++);
+      if (c == '\0') report_error("invalid format string");
+      if (prev == '{') {
+        if (c == '}' || c == ':') {
+          if (next_arg_id < 0)
+            report_error(
+                "cannot switch from manual to automatic argument indexing");
+          auto id = to_unsigned(next_arg_id++);
+          char digits[digits10<unsigned>() + 1];
+          auto end = format_decimal<char>(digits, id, count_digits(id));
+          for (auto p = digits; p != end; ++p) put(*p);
+        } else if (c >= '0' && c <= '9') {
+          if (next_arg_id > 0)
+            report_error(
+                "cannot switch from automatic to manual argument indexing");
+          next_arg_id = -1;
+        }
+      }
+      put(c);
+      if (c == '{')
+        ++depth;
+      else if (c == '}')
+        --depth;
+    }
+    detail::vformat_to(buf, string_view(field, size), args);
+  }
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// A string stored in flash, see `fmt::flash`.
+struct flash_string {
+  const __FlashStringHelper* str;
+};
+
+/**
+ * Returns an argument that formats a string stored in flash without copying
+ * it to RAM first:
+ *
+ *     fmt::format_to(buf, "{}: {}", fmt::flash(F("state")), state);
+ */
+inline auto flash(const __FlashStringHelper* s) -> flash_string {
+  return {s};
+}
+
+template <> struct formatter<flash_string> {
+ private:
+  detail::dynamic_format_specs<> specs_;
+
+ public:
+  FMT_CONSTEXPR auto parse(format_parse_context& ctx) -> const char* {
+    return detail::parse_format_specs(ctx.begin(), ctx.end(), specs_, ctx,
+                                      detail::type::string_type);
+  }
+
+  auto format(flash_string s, format_context& ctx) const
+      -> format_context::iterator {
+    auto specs = specs_;
+    detail::handle_dynamic_spec(specs.dynamic_width(), specs.width,
+                                specs.width_ref, ctx);
+    detail::handle_dynamic_spec(specs.dynamic_precision(), specs.precision,
+                                specs.precision_ref, ctx);
+    auto str = reinterpret_cast<const char*>(s.str);
+    // Find the size in code units and the width in code points, stopping
+    // after `precision` code points.
+    size_t max_width = specs.precision >= 0
+                           ? detail::to_unsigned(specs.precision)
+                           : detail::max_value<size_t>();
+    size_t size = 0, width = 0;
+    for (char c; (c = detail::read_flash(str + size)) != '\0'; ++size) {
+      if ((static_cast<unsigned char>(c) & 0xc0) == 0x80) continue;
+      if (width == max_width) break;
+      ++width;
+    }
+    return detail::write_padded<char>(
+        ctx.out(), specs, size, width, [=](appender it) {
+          auto& buf = detail::get_container(it);
+          for (size_t i = 0; i < size; ++i)
+            buf.push_back(detail::read_flash(str + i));
+          return it;
+        });
+  }
+};
+
+/**
+ * Formats `args` according to the format string `fmt` stored in flash and
+ * returns the result as a string:
+ *
+ *     std::string s = fmt::format(F("T={:.1f}C"), temp);
+ */
+template <typename... T>
+FMT_NODISCARD auto format(const __FlashStringHelper* fmt, T&&... args)
+    -> std::string {
+  auto buf = memory_buffer();
+  detail::vformat_flash_to(buf, reinterpret_cast<const char*>(fmt),
+                           vargs<T...>{{args...}});
+  return to_string(buf);
+}
+
+template <typename OutputIt, typename... T,
+          FMT_ENABLE_IF(detail::is_output_iterator<remove_cvref_t<OutputIt>,
+                                                   char>::value)>
+auto format_to(OutputIt&& out, const __FlashStringHelper* fmt, T&&... args)
+    -> remove_cvref_t<OutputIt> {
+  auto&& buf = detail::get_buffer<char>(out);
+  detail::vformat_flash_to(buf, reinterpret_cast<const char*>(fmt),
+                           vargs<T...>{{args...}});
+  return detail::get_iterator(buf, out);
+}
+
+template <typename OutputIt, typename... T,
+          FMT_ENABLE_IF(detail::is_output_iterator<OutputIt, char>::value)>
+auto format_to_n(OutputIt out, size_t n, const __FlashStringHelper* fmt,
+                 T&&... args) -> format_to_n_result<OutputIt> {
+  using traits = detail::fixed_buffer_traits;
+  auto buf = detail::iterator_buffer<OutputIt, char, traits>(out, n);
+  detail::vformat_flash_to(buf, reinterpret_cast<const char*>(fmt),
+                           vargs<T...>{{args...}});
+  return {buf.out(), buf.count()};
+}
+
+template <size_t N, typename... T>
+auto format_to(char (&out)[N], const __FlashStringHelper* fmt, T&&... args)
+    -> format_to_result {
+  auto result = format_to_n(out, N, fmt, static_cast<T&&>(args)...);
+  return {result.out, result.size > N};
+}
+
+/// Appends the output to the Arduino String `out`.
+template <typename... T>
+auto format_to(String& out, const __FlashStringHelper* fmt, T&&... args)
+    -> String& {
+  detail::string_buffer<String> buf(out);
+  detail::vformat_flash_to(buf, reinterpret_cast<const char*>(fmt),
+                           vargs<T...>{{args...}});
+  return out;
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
@@ -0,0 +1,122 @@
+#pragma once
+
+// COBS and SLIP framing of formatted output while it is written.
+//
+// Binary-safe serial protocols delimit frames with a byte that must not occur
+// inside a frame. `fmt::cobs_sink` and `fmt::slip_sink` wrap a sink (see
+// sink.h) and encode the output on its way to the sink, so a frame doesn't
+// have to be formatted into a buffer first and encoded into a second one:
+//
+//     auto frame = fmt::cobs_sink<HardwareSerial>(Serial1);
+//     fmt::format_to(frame, "{},{},{:.2f}", id, millis(), value);
+//     frame.finish();  // ends the frame with a zero byte
+//
+// COBS (Consistent Overhead Byte Stuffing) removes all zero bytes at the cost
+// of one byte per 254 bytes of output and needs a 255 byte block buffer. SLIP
+// (RFC 1055) escapes the 0xC0 delimiter and 0xDB, which can double the size of
+// binary data, but only needs a small staging buffer.
+
+#include "sink.h"
+
+FMT_BEGIN_NAMESPACE
+FMT_BEGIN_EXPORT
+
+/// A sink that encodes the output with COBS and writes it to `Sink`.
+template <typename Sink> class cobs_sink {
+ private:
+  enum : size_t { max_block_size = 254 };
+
+  Sink& sink_;
+  // The code byte followed by up to 254 non-zero bytes.
+  unsigned char block_[max_block_size + 1];
+  size_t size_ = 0;
+  // Set after a block of 254 bytes which has no implicit zero at its end.
+  bool after_full_block_ = false;
+
+  void write_block() {
+    block_[0] = static_cast<unsigned char>(size_ + 1);
+    detail::write_to_sink(sink_, reinterpret_cast<const char*>(block_),
+                          size_ + 1);
+    size_ = 0;
+  }
+
+ public:
+  explicit cobs_sink(Sink& sink) : sink_(sink) {}
+
+  auto write(const char* data, size_t size) -> size_t {
+    for (size_t i = 0; i < size; ++i) {
+      auto c = static_cast<unsigned char>(data[i]);
+      after_full_block_ = false;
+      if (c == 0) {
+        write_block();
+        continue;
+      }
+      block_[++size_] = c;
+      if (size_ == max_block_size) {
+        write_block();
+        after_full_block_ = true;
+      }
+    }
+    return size;
+  }
+
+  /// Ends the frame. If `delimiter` is true it is followed by a zero byte.
+  void finish(bool delimiter = true) {
+    if (size_ != 0 || !after_full_block_) write_block();
+    after_full_block_ = false;
+    if (delimiter) detail::write_to_sink(sink_, "", 1);
+  }
+};
+
+/// A sink that encodes the output with SLIP and writes it to `Sink`.
+template <typename Sink> class slip_sink {
+ private:
+  enum : unsigned char {
+    end = 0xc0,
+    esc = 0xdb,
+    esc_end = 0xdc,
+    esc_esc = 0xdd
+  };
+
+  Sink& sink_;
+  unsigned char out_[32];
+  size_t size_ = 0;
+
+  void put(unsigned char c) {
+    if (size_ == sizeof(out_)) flush_output();
+    out_[size_++] = c;
+  }
+
+  void flush_output() {
+    detail::write_to_sink(sink_, reinterpret_cast<const char*>(out_), size_);
+    size_ = 0;
+  }
+
+ public:
+  explicit slip_sink(Sink& sink) : sink_(sink) {}
+
+  auto write(const char* data, size_t size) -> size_t {
+    for (size_t i = 0; i < size; ++i) {
+      auto c = static_cast<unsigned char>(data[i]);
+      if (c == end) {
+        put(esc);
+        put(esc_end);
+      } else if (c == esc) {
+        put(esc);
+        put(esc_esc);
+      } else {
+        put(c);
+      }
+    }
+    return size;
+  }
+
+  /// Ends the frame with the END byte and writes it to the sink.
+  void finish() {
+    put(end);
+    flush_output();
+  }
+};
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
@@ -0,0 +1,517 @@
+#pragma once
+
+// Parsing integers and floating point numbers.
+//
+// `strtol` and `strtod` depend on the C locale, need null-terminated input
+// and, in the case of `strtod`, add several kilobytes of code that is slow on
+// microcontrollers. `fmt::from_chars` has the interface of `std::from_chars`,
+// which is not available on most Arduino toolchains:
+//
+//     double value;
+//     auto result = fmt::from_chars(begin, end, value);
+//     if (!result) Serial.println("not a number");
+//
+// Floating point numbers are rounded correctly. The common case is handled by
+// the Eisel-Lemire algorithm, which multiplies the leading 19 decimal digits
+// by a 128-bit approximation of the power of ten, using the table that {fmt}
+// already has for formatting with Dragonbox (see format-inl.h). When the
+// result is too close to a halfway point between two floating point numbers
+// the decimal input is compared to the halfway point exactly using big
+// integers on the stack.
+
+#include "../fmt.h"
+
+FMT_BEGIN_NAMESPACE
+
+/// Formats accepted by `fmt::from_chars` for floating point numbers.
+enum class chars_format : unsigned char {
+  scientific = 1,  // An exponent is required.
+  fixed = 2,       // An exponent is not allowed.
+  general = fixed | scientific
+};
+
+/// The result of `fmt::from_chars`.
+struct from_chars_result {
+  /// Pointer past the last character of the number or to the beginning of
+  /// the input if there is no number.
+  const char* ptr;
+  std::errc ec;
+
+  explicit operator bool() const noexcept { return ec == std::errc(); }
+};
+
+namespace detail {
+
+inline auto digit_value(char c) -> unsigned {
+  if (c >= '0' && c <= '9') return static_cast<unsigned>(c - '0');
+  if (c >= 'a' && c <= 'z') return static_cast<unsigned>(c - 'a' + 10);
+  if (c >= 'A' && c <= 'Z') return static_cast<unsigned>(c - 'A' + 10);
+  return 36;
+}
+
+// Parses an unsigned number in `base` and sets `overflow` if it doesn't fit
+// into `max`.
+inline auto parse_unsigned(const char* begin, const char* end, unsigned base,
+                           unsigned long long max, unsigned long long& value,
+                           bool& overflow) -> const char* {
+  value = 0;
+  overflow = false;
+  auto p = begin;
+  for (unsigned d; p != end && (d = digit_value(*p)) < base; ++p) {
+    if (value > (max - d) / base) overflow = true;
+    value = value * base + d;
+  }
+  return p;
+}
+
+// Properties of the IEEE 754 binary format of `T`.
+template <typename T> struct float_format {
+  static_assert(std::numeric_limits<T>::is_iec559 &&
+                    (std::numeric_limits<T>::digits == 24 ||
+                     std::numeric_limits<T>::digits == 53),
+                "unsupported floating point type");
+
+  using bits_type = conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+
+  static constexpr int significand_bits = std::numeric_limits<T>::digits - 1;
+  static constexpr int bias = std::numeric_limits<T>::max_exponent - 1;
+  static constexpr uint64_t max_exponent_field = uint64_t(bias) * 2 + 1;
+  static constexpr uint64_t infinity_bits = max_exponent_field
+                                            << significand_bits;
+  // The exponent of the least significant bit of subnormals.
+  static constexpr int min_exponent = 1 - bias - significand_bits;
+  static constexpr bool is_double = significand_bits == 52;
+  // Inputs w * 10^q with w < 10^19 and q outside [min_q, max_q] round to zero
+  // or infinity.
+  static constexpr int min_q = is_double ? -342 : -65;
+  static constexpr int max_q = is_double ? 309 : 39;
+  // The maximum number of significant digits of a halfway point between two
+  // consecutive values and the number of 32-bit limbs to compare it exactly.
+  static constexpr int max_digits = is_double ? 769 : 114;
+  static constexpr int bigint_limbs = is_double ? 128 : 24;
+  // The largest power of ten that is exactly representable.
+  static constexpr int max_exact_pow10 = is_double ? 22 : 10;
+};
+
+// A finite binary floating point number m * 2^e.
+struct binary_float {
+  uint64_t m;
+  int e;
+};
+
+template <typename T>
+auto to_binary_float(typename float_format<T>::bits_type bits)
+    -> binary_float {
+  using ff = float_format<T>;
+  auto mask = (uint64_t(1) << ff::significand_bits) - 1;
+  auto exponent = static_cast<int>(bits >> ff::significand_bits);
+  uint64_t m = bits & mask;
+  if (exponent == 0) return {m, ff::min_exponent};
+  return {m | (mask + 1), exponent + ff::min_exponent - 1};
+}
+
+// Rounds z * 2^e, where the most significant bit of z is set and `sticky`
+// indicates nonzero bits below z, to the nearest value of type `T` and returns
+// its bits. Returns the bits of infinity on overflow.
+template <typename T>
+auto round_to_float(uint64_t z, int e, bool sticky) ->
+    typename float_format<T>::bits_type {
+  using ff = float_format<T>;
+  using bits_type = typename ff::bits_type;
+  int shift = 63 - ff::significand_bits;
+  // Keep fewer bits if the result is subnormal.
+  if (e + shift < ff::min_exponent) shift = ff::min_exponent - e;
+  uint64_t m;
+  bool round_up;
+  if (shift > 64) return 0;
+  if (shift == 64) {
+    m = 0;
+    auto half = uint64_t(1) << 63;
+    round_up = z > half || (z == half && sticky);
+  } else {
+    m = z >> shift;
+    uint64_t rest = z & ((uint64_t(1) << shift) - 1);
+    uint64_t half = uint64_t(1) << (shift - 1);
+    round_up = rest > half || (rest == half && (sticky || (m & 1) != 0));
+  }
+  m += round_up ? 1 : 0;
+  e += shift;
+  if (m >> (ff::significand_bits + 1) != 0) {
+    m >>= 1;
+    ++e;
+  }
+  // A subnormal, possibly rounded up to the smallest normal value.
+  if (m >> ff::significand_bits == 0 || e == ff::min_exponent)
+    return static_cast<bits_type>(m);
+  auto exponent = static_cast<uint64_t>(e - ff::min_exponent + 1);
+  if (exponent >= ff::max_exponent_field)
+    return static_cast<bits_type>(ff::infinity_bits);
+  auto mask = (uint64_t(1) << ff::significand_bits) - 1;
+  return static_cast<bits_type>(exponent << ff::significand_bits | (m & mask));
+}
+
+template <typename T>
+auto round_to_float(uint128_fallback u, int e) ->
+    typename float_format<T>::bits_type {
+  int shift = countl_zero(u.high());
+  auto z = u.high() << shift;
+  if (shift != 0) z |= u.low() >> (64 - shift);
+  return round_to_float<T>(z, e + 64 - shift, (u.low() << shift) != 0);
+}
+
+// Computes w * 10^q rounded to `T` with the Eisel-Lemire algorithm. Returns
+// false if the result can't be determined from the 128-bit approximation of
+// 10^q. Otherwise `bits` is set to the result. In both cases `lower` is set to
+// a value that is at most one unit in the last place below the result.
+template <typename T>
+auto eisel_lemire(uint64_t w, int q,
+                  typename float_format<T>::bits_type& bits,
+                  typename float_format<T>::bits_type& lower) -> bool {
+  int lz = countl_zero(w);
+  w <<= lz;
+  // 10^q = pow10 * 2^(floor_log2_pow10(q) - 127) with pow10 in [2^127, 2^128)
+  // at most 3 units above the exact value.
+  uint128_fallback u =
+      dragonbox::umul192_upper128(w, dragonbox::get_cached_power(q));
+  int e = dragonbox::floor_log2_pow10(q) - 127 + 64 - lz;
+  // The exact product is in (u - 3, u + 1) where the upper bound accounts for
+  // the discarded low bits.
+  if (u.high() == max_value<uint64_t>()) return false;
+  lower = round_to_float<T>(u - 4, e);
+  uint128_fallback upper = u;
+  upper += 2;
+  bits = round_to_float<T>(upper, e);
+  return bits == lower;
+}
+
+// An unsigned integer with a fixed number of 32-bit limbs.
+template <int LIMBS> class fixed_bigint {
+ private:
+  uint32_t limbs_[LIMBS];
+  int size_ = 0;
+
+ public:
+  explicit fixed_bigint(uint64_t value) {
+    for (; value != 0; value >>= 32)
+      limbs_[size_++] = static_cast<uint32_t>(value);
+  }
+
+  fixed_bigint(const fixed_bigint&) = delete;
+  void operator=(const fixed_bigint&) = delete;
+
+  // Computes *this = *this * factor + addend.
+  void multiply_add(uint32_t factor, uint32_t addend) {
+    uint64_t carry = addend;
+    for (int i = 0; i < size_; ++i) {
+      carry += uint64_t(limbs_[i]) * factor;
+      limbs_[i] = static_cast<uint32_t>(carry);
+      carry >>= 32;
+    }
+    if (carry == 0) return;
+    FMT_ASSERT(size_ < LIMBS, "bigint overflow");
+    limbs_[size_++] = static_cast<uint32_t>(carry);
+  }
+
+  void multiply_pow10(int exp) {
+    for (; exp >= 9; exp -= 9) multiply_add(1000000000, 0);
+    static const uint32_t small_pow10[] = {1,      10,      100,     1000,
+                                           10000,  100000,  1000000, 10000000,
+                                           100000000};
+    if (exp != 0) multiply_add(small_pow10[exp], 0);
+  }
+
+  void shift_left(int shift) {
+    if (size_ == 0) return;
+    int limb_shift = shift / 32, bit_shift = shift % 32;
+    FMT_ASSERT(size_ + limb_shift < LIMBS, "bigint overflow");
+    uint32_t carry = 0;
+    if (bit_shift != 0) {
+      for (int i = 0; i < size_; ++i) {
+        uint32_t limb = limbs_[i];
+        limbs_[i] = limb << bit_shift | carry;
+        carry = limb >> (32 - bit_shift);
+      }
+    }
+    if (carry != 0) limbs_[size_++] = carry;
+    if (limb_shift == 0) return;
+    for (int i = size_; i-- > 0;) limbs_[i + limb_shift] = limbs_[i];
+    for (int i = 0; i < limb_shift; ++i) limbs_[i] = 0;
+    size_ += limb_shift;
+  }
+
+  friend auto compare(const fixed_bigint& lhs, const fixed_bigint& rhs)
+      -> int {
+    if (lhs.size_ != rhs.size_) return lhs.size_ > rhs.size_ ? 1 : -1;
+    for (int i = lhs.size_; i-- > 0;) {
+      if (lhs.limbs_[i] != rhs.limbs_[i])
+        return lhs.limbs_[i] > rhs.limbs_[i] ? 1 : -1;
+    }
+    return 0;
+  }
+};
+
+// The significant digits of a decimal number: the digits in [begin, end),
+// skipping a decimal point, times 10^exp where exp is the exponent of the
+// last digit.
+struct decimal_digits {
+  const char* begin;
+  const char* end;
+  int num_digits;
+  int exp;
+};
+
+// Compares the decimal number `d` with the halfway point above m * 2^e and
+// returns a negative value, zero or a positive value if `d` is less, equal or
+// greater.
+template <typename T>
+auto compare_halfway(const decimal_digits& d, uint64_t m, int e) -> int {
+  using ff = float_format<T>;
+  using bigint = fixed_bigint<ff::bigint_limbs>;
+  // Use at most max_digits digits; the rest only matter if they are nonzero
+  // and the other digits are equal to the halfway point.
+  bigint lhs(0);
+  int num_digits = 0;
+  bool truncated = false;
+  for (auto p = d.begin; p != d.end; ++p) {
+    if (*p == '.') continue;
+    if (num_digits == ff::max_digits) {
+      if (*p != '0') truncated = true;
+      continue;
+    }
+    lhs.multiply_add(10, static_cast<uint32_t>(*p - '0'));
+    ++num_digits;
+  }
+  int exp10 = d.exp + (d.num_digits - num_digits);
+  // The halfway point is (2 * m + 1) * 2^(e - 1).
+  bigint rhs(2 * m + 1);
+  int exp2 = e - 1;
+  if (exp10 >= 0)
+    lhs.multiply_pow10(exp10);
+  else
+    rhs.multiply_pow10(-exp10);
+  if (exp2 >= 0)
+    rhs.shift_left(exp2);
+  else
+    lhs.shift_left(-exp2);
+  int result = compare(lhs, rhs);
+  return result == 0 && truncated ? 1 : result;
+}
+
+// Finds the correctly rounded value of `d` starting from `bits` which must be
+// close to it.
+template <typename T>
+auto round_decimal(const decimal_digits& d,
+                   typename float_format<T>::bits_type bits) ->
+    typename float_format<T>::bits_type {
+  using ff = float_format<T>;
+  auto inf = static_cast<typename ff::bits_type>(ff::infinity_bits);
+  for (;;) {
+    if (bits != inf) {
+      auto f = to_binary_float<T>(bits);
+      int cmp = compare_halfway<T>(d, f.m, f.e);
+      if (cmp > 0 || (cmp == 0 && (f.m & 1) != 0)) {
+        ++bits;
+        continue;
+      }
+    }
+    if (bits == 0) break;
+    auto f = to_binary_float<T>(bits - 1);
+    int cmp = compare_halfway<T>(d, f.m, f.e);
+    if (cmp < 0 || (cmp == 0 && (f.m & 1) == 0)) {
+      --bits;
+      continue;
+    }
+    break;
+  }
+  return bits;
+}
+
+inline auto starts_with_ignore_case(const char* begin, const char* end,
+                                    const char* s) -> bool {
+  for (; *s; ++s, ++begin) {
+    if (begin == end || (*begin | 0x20) != *s) return false;
+  }
+  return true;
+}
+
+template <typename T>
+auto parse_float(const char* first, const char* last, T& value,
+                 chars_format fmt) -> from_chars_result {
+  using ff = float_format<T>;
+  using bits_type = typename ff::bits_type;
+  auto p = first;
+  bool negative = p != last && *p == '-';
+  if (negative) ++p;
+  bits_type sign = negative ? bits_type(1) << (sizeof(T) * 8 - 1) : 0;
+
+  if (p != last && (*p | 0x20) >= 'i') {
+    bits_type bits = 0;
+    if (starts_with_ignore_case(p, last, "inf")) {
+      p += starts_with_ignore_case(p, last, "infinity") ? 8 : 3;
+      bits = static_cast<bits_type>(ff::infinity_bits);
+    } else if (starts_with_ignore_case(p, last, "nan")) {
+      p += 3;
+      // An optional n-char-sequence in parentheses.
+      if (p != last && *p == '(') {
+        auto q = p + 1;
+        while (q != last && (digit_value(*q) < 36 || *q == '_')) ++q;
+        if (q != last && *q == ')') p = q + 1;
+      }
+      bits = static_cast<bits_type>(ff::infinity_bits |
+                                    uint64_t(1) << (ff::significand_bits - 1));
+    } else {
+      return {first, std::errc::invalid_argument};
+    }
+    value = bit_cast<T>(static_cast<bits_type>(bits | sign));
+    return {p, std::errc()};
+  }
+
+  // Read up to 19 significant digits into w.
+  decimal_digits digits = {p, p, 0, 0};
+  uint64_t w = 0;
+  int num_w_digits = 0, exp = 0;
+  bool truncated = false, has_digits = false;
+  auto add_digit = [&](char c, bool fraction) {
+    has_digits = true;
+    auto d = static_cast<unsigned>(c - '0');
+    if (w == 0 && d == 0) {
+      // A leading zero.
+      if (fraction) --exp;
+      digits.begin = p + 1;
+      return;
+    }
+    ++digits.num_digits;
+    digits.end = p + 1;
+    if (num_w_digits < 19) {
+      w = w * 10 + d;
+      ++num_w_digits;
+      if (fraction) --exp;
+    } else {
+      if (!fraction) ++exp;
+      if (d != 0) truncated = true;
+    }
+  };
+  for (; p != last && *p >= '0' && *p <= '9'; ++p) add_digit(*p, false);
+  if (p != last && *p == '.') {
+    if (w == 0) digits.begin = p + 1;
+    for (++p; p != last && *p >= '0' && *p <= '9'; ++p) add_digit(*p, true);
+  }
+  if (!has_digits) return {first, std::errc::invalid_argument};
+
+  if ((static_cast<int>(fmt) & static_cast<int>(chars_format::scientific)) !=
+          0 &&
+      p != last && (*p | 0x20) == 'e') {
+    auto q = p + 1;
+    bool negative_exp = q != last && *q == '-';
+    if (q != last && (*q == '-' || *q == '+')) ++q;
+    if (q != last && *q >= '0' && *q <= '9') {
+      int e = 0;
+      for (; q != last && *q >= '0' && *q <= '9'; ++q) {
+        if (e < 100000) e = e * 10 + (*q - '0');
+      }
+      exp += negative_exp ? -e : e;
+      p = q;
+    } else if (fmt == chars_format::scientific) {
+      return {first, std::errc::invalid_argument};
+    }
+  } else if (fmt == chars_format::scientific) {
+    return {first, std::errc::invalid_argument};
+  }
+
+  bits_type bits = 0;
+  if (w == 0) {
+    bits = 0;
+  } else if (exp < ff::min_q) {
+    return {p, std::errc::result_out_of_range};
+  } else if (exp > ff::max_q) {
+    return {p, std::errc::result_out_of_range};
+  } else if (!truncated && w <= uint64_t(1) << (ff::significand_bits + 1) &&
+             exp >= -ff::max_exact_pow10 && exp <= ff::max_exact_pow10) {
+    // Both w and 10^|exp| are exact so one operation rounds correctly.
+    static constexpr double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    T v = static_cast<T>(w);
+    auto scale = static_cast<T>(pow10[exp < 0 ? -exp : exp]);
+    v = exp < 0 ? v / scale : v * scale;
+    bits = bit_cast<bits_type>(v);
+  } else {
+    bits_type lower = 0;
+    bool exact = false;
+    if (exp >= dragonbox::float_info<double>::min_k) {
+      exact = eisel_lemire<T>(w, exp, bits, lower);
+      // The first 19 digits are followed by more, so the number is between
+      // w * 10^exp and (w + 1) * 10^exp.
+      bits_type upper = 0, unused = 0;
+      if (exact && truncated)
+        exact = eisel_lemire<T>(w + 1, exp, upper, unused) && upper == bits;
+    } else {
+      // Below the table, which is only possible for double: start from an
+      // approximation that is off by a few units in the last place.
+      bits_type unused = 0;
+      eisel_lemire<T>(w, exp + 50, unused, lower);
+      lower = bit_cast<bits_type>(bit_cast<T>(lower) * static_cast<T>(1e-50));
+    }
+    if (!exact) {
+      digits.exp = exp + num_w_digits - digits.num_digits;
+      bits = round_decimal<T>(digits, lower);
+    }
+  }
+  // A nonzero number that rounds to zero or infinity is out of range.
+  if ((bits == 0 && w != 0) || bits == ff::infinity_bits)
+    return {p, std::errc::result_out_of_range};
+  value = bit_cast<T>(static_cast<bits_type>(bits | sign));
+  return {p, std::errc()};
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/**
+ * Parses an integer in `base` (2 to 36) from [`first`, `last`) like
+ * `std::from_chars`: an optional minus sign for signed types followed by
+ * digits, without a prefix or leading whitespace. On error `value` is not
+ * modified and `ec` is `std::errc::invalid_argument` if there are no digits
+ * or `std::errc::result_out_of_range` if the number doesn't fit into `T`.
+ */
+template <typename T,
+          FMT_ENABLE_IF(std::is_integral<T>::value &&
+                        !std::is_same<T, bool>::value)>
+auto from_chars(const char* first, const char* last, T& value, int base = 10)
+    -> from_chars_result {
+  FMT_ASSERT(base >= 2 && base <= 36, "invalid base");
+  using unsigned_type = typename std::make_unsigned<T>::type;
+  auto p = first;
+  bool negative = std::is_signed<T>::value && p != last && *p == '-';
+  if (negative) ++p;
+  unsigned long long max = detail::max_value<unsigned_type>();
+  if (std::is_signed<T>::value) max = max / 2 + (negative ? 1 : 0);
+  unsigned long long n = 0;
+  bool overflow = false;
+  auto end = detail::parse_unsigned(p, last, static_cast<unsigned>(base), max,
+                                    n, overflow);
+  if (end == p) return {first, std::errc::invalid_argument};
+  if (overflow || n > max) return {end, std::errc::result_out_of_range};
+  auto u = static_cast<unsigned_type>(n);
+  value = static_cast<T>(negative ? unsigned_type(0 - u) : u);
+  return {end, std::errc()};
+}
+
+/**
+ * Parses a floating point number from [`first`, `last`) like
+ * `std::from_chars`: an optional minus sign, digits with an optional decimal
+ * point and an exponent as allowed by `fmt`, or "inf", "infinity" or "nan" in
+ * any case. Hexadecimal floating point numbers are not supported. The result
+ * is rounded to nearest. If it overflows or a nonzero number underflows to
+ * zero `value` is not modified and `ec` is `std::errc::result_out_of_range`.
+ */
+template <typename T, FMT_ENABLE_IF(std::is_floating_point<T>::value)>
+auto from_chars(const char* first, const char* last, T& value,
+                chars_format fmt = chars_format::general)
+    -> from_chars_result {
+  return detail::parse_float(first, last, value, fmt);
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
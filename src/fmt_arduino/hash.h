@@ -0,0 +1,242 @@
+#pragma once
+
+// Hashing formatted output without storing it.
+//
+// Log deduplication and cache keys need a hash of a formatted message, not
+// the message itself. `fmt::format_hash` formats into a small staging array
+// on the stack and feeds each full block to an incremental hash, so no
+// string is allocated:
+//
+//     uint32_t key = fmt::format_hash<fmt::xxh32>("{}/{}", topic, id);
+//
+// The hashes have the same `update`/`value` interface as the checksums in
+// checksum.h, which can be used with `format_hash` as well. The xxHash
+// functions use seed 0 by default and produce the same values as the
+// reference implementation.
+
+#include "sink.h"
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+template <typename Hash> struct hash_sink {
+  Hash hash;
+
+  void write(const char* data, size_t size) { hash.update(data, size); }
+};
+
+inline auto rotl32(uint32_t x, int r) -> uint32_t {
+  return x << r | x >> (32 - r);
+}
+inline auto rotl64(uint64_t x, int r) -> uint64_t {
+  return x << r | x >> (64 - r);
+}
+
+inline auto read_le32(const unsigned char* p) -> uint32_t {
+  return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 |
+         uint32_t(p[3]) << 24;
+}
+inline auto read_le64(const unsigned char* p) -> uint64_t {
+  return read_le32(p) | uint64_t(read_le32(p + 4)) << 32;
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// 32-bit FNV-1a.
+class fnv1a_32 {
+ private:
+  uint32_t value_ = 2166136261u;
+
+ public:
+  void update(const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+      value_ = (value_ ^ static_cast<unsigned char>(data[i])) * 16777619u;
+  }
+  auto value() const -> uint32_t { return value_; }
+};
+
+/// 64-bit FNV-1a.
+class fnv1a_64 {
+ private:
+  uint64_t value_ = 14695981039346656037ull;
+
+ public:
+  void update(const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+      value_ =
+          (value_ ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+  }
+  auto value() const -> uint64_t { return value_; }
+};
+
+/// XXH32 computed incrementally.
+class xxh32 {
+ private:
+  static constexpr uint32_t p1 = 2654435761u, p2 = 2246822519u,
+                            p3 = 3266489917u, p4 = 668265263u,
+                            p5 = 374761393u;
+
+  uint32_t seed_;
+  uint32_t acc_[4];
+  unsigned char stripe_[16];
+  size_t stripe_size_ = 0;
+  uint64_t total_size_ = 0;
+
+  static auto round(uint32_t acc, uint32_t input) -> uint32_t {
+    return detail::rotl32(acc + input * p2, 13) * p1;
+  }
+
+  void consume(const unsigned char* p) {
+    for (int i = 0; i < 4; ++i)
+      acc_[i] = round(acc_[i], detail::read_le32(p + i * 4));
+  }
+
+ public:
+  explicit xxh32(uint32_t seed = 0)
+      : seed_(seed), acc_{seed + p1 + p2, seed + p2, seed, seed - p1} {}
+
+  void update(const char* data, size_t size) {
+    auto p = reinterpret_cast<const unsigned char*>(data);
+    total_size_ += size;
+    if (stripe_size_ != 0) {
+      size_t n = min_of(size, sizeof(stripe_) - stripe_size_);
+      memcpy(stripe_ + stripe_size_, p, n);
+      stripe_size_ += n;
+      p += n;
+      size -= n;
+      if (stripe_size_ < sizeof(stripe_)) return;
+      consume(stripe_);
+      stripe_size_ = 0;
+    }
+    for (; size >= sizeof(stripe_); size -= sizeof(stripe_)) {
+      consume(p);
+      p += sizeof(stripe_);
+    }
+    memcpy(stripe_, p, size);
+    stripe_size_ = size;
+  }
+
+  auto value() const -> uint32_t {
+    uint32_t h = total_size_ >= sizeof(stripe_)
+                     ? detail::rotl32(acc_[0], 1) + detail::rotl32(acc_[1], 7) +
+                           detail::rotl32(acc_[2], 12) +
+                           detail::rotl32(acc_[3], 18)
+                     : seed_ + p5;
+    h += static_cast<uint32_t>(total_size_);
+    const unsigned char* p = stripe_;
+    size_t size = stripe_size_;
+    for (; size >= 4; p += 4, size -= 4)
+      h = detail::rotl32(h + detail::read_le32(p) * p3, 17) * p4;
+    for (; size > 0; ++p, --size) h = detail::rotl32(h + *p * p5, 11) * p1;
+    h ^= h >> 15;
+    h *= p2;
+    h ^= h >> 13;
+    h *= p3;
+    return h ^ h >> 16;
+  }
+};
+
+/// XXH64 computed incrementally.
+class xxh64 {
+ private:
+  static constexpr uint64_t p1 = 11400714785074694791ull,
+                            p2 = 14029467366897019727ull,
+                            p3 = 1609587929392839161ull,
+                            p4 = 9650029242287828579ull,
+                            p5 = 2870177450012600261ull;
+
+  uint64_t seed_;
+  uint64_t acc_[4];
+  unsigned char stripe_[32];
+  size_t stripe_size_ = 0;
+  uint64_t total_size_ = 0;
+
+  static auto round(uint64_t acc, uint64_t input) -> uint64_t {
+    return detail::rotl64(acc + input * p2, 31) * p1;
+  }
+
+  static auto merge(uint64_t h, uint64_t acc) -> uint64_t {
+    return (h ^ round(0, acc)) * p1 + p4;
+  }
+
+  void consume(const unsigned char* p) {
+    for (int i = 0; i < 4; ++i)
+      acc_[i] = round(acc_[i], detail::read_le64(p + i * 8));
+  }
+
+ public:
+  explicit xxh64(uint64_t seed = 0)
+      : seed_(seed), acc_{seed + p1 + p2, seed + p2, seed, seed - p1} {}
+
+  void update(const char* data, size_t size) {
+    auto p = reinterpret_cast<const unsigned char*>(data);
+    total_size_ += size;
+    if (stripe_size_ != 0) {
+      size_t n = min_of(size, sizeof(stripe_) - stripe_size_);
+      memcpy(stripe_ + stripe_size_, p, n);
+      stripe_size_ += n;
+      p += n;
+      size -= n;
+      if (stripe_size_ < sizeof(stripe_)) return;
+      consume(stripe_);
+      stripe_size_ = 0;
+    }
+    for (; size >= sizeof(stripe_); size -= sizeof(stripe_)) {
+      consume(p);
+      p += sizeof(stripe_);
+    }
+    memcpy(stripe_, p, size);
+    stripe_size_ = size;
+  }
+
+  auto value() const -> uint64_t {
+    uint64_t h = seed_ + p5;
+    if (total_size_ >= sizeof(stripe_)) {
+      h = detail::rotl64(acc_[0], 1) + detail::rotl64(acc_[1], 7) +
+          detail::rotl64(acc_[2], 12) + detail::rotl64(acc_[3], 18);
+      for (int i = 0; i < 4; ++i) h = merge(h, acc_[i]);
+    }
+    h += total_size_;
+    const unsigned char* p = stripe_;
+    size_t size = stripe_size_;
+    for (; size >= 8; p += 8, size -= 8)
+      h = detail::rotl64(h ^ round(0, detail::read_le64(p)), 27) * p1 + p4;
+    if (size >= 4) {
+      h = detail::rotl64(h ^ detail::read_le32(p) * p1, 23) * p2 + p3;
+      p += 4;
+      size -= 4;
+    }
+    for (; size > 0; ++p, --size) h = detail::rotl64(h ^ *p * p5, 11) * p1;
+    h ^= h >> 33;
+    h *= p2;
+    h ^= h >> 29;
+    h *= p3;
+    return h ^ h >> 32;
+  }
+};
+
+/// Formats `args` and returns the `Hash` of the output, staging at most `N`
+/// characters at a time.
+template <typename Hash, size_t N = 64>
+auto vformat_hash(string_view fmt, format_args args)
+    -> decltype(Hash().value()) {
+  detail::hash_sink<Hash> sink;
+  vformat_to<N>(sink, fmt, args);
+  return sink.hash.value();
+}
+
+/**
+ * Formats `args` according to the format string `fmt` and returns the `Hash`
+ * (e.g. `fmt::fnv1a_32`, `fmt::xxh64` or `fmt::crc32`) of the output without
+ * storing or allocating it.
+ */
+template <typename Hash, size_t N = 64, typename... T>
+auto format_hash(format_string<T...> fmt, T&&... args)
+    -> decltype(Hash().value()) {
+  return vformat_hash<Hash, N>(fmt.str, vargs<T...>{{args...}});
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
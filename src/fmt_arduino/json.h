@@ -0,0 +1,285 @@
+#pragma once
+
+// Formatting values as JSON.
+//
+// `fmt::json(value)` formats numbers, booleans, strings, ranges, maps, tuples
+// and optionals as JSON text straight into the output, without building a
+// document tree first:
+//
+//     std::map<std::string, std::vector<float>> readings = ...;
+//     fmt::format_to(out, R"({{"id":{},"readings":{}}})", fmt::json(id),
+//                    fmt::json(readings));
+//
+// Ranges become arrays, maps with string or numeric keys become objects (other
+// key types are rejected at compile time), tuples and pairs become arrays,
+// empty optionals, null string pointers and non-finite floating point numbers
+// become null. Strings are escaped as required by RFC 8259 and
+// are expected to be UTF-8; the escape scanner checks a machine word at a
+// time, so the common case of plain text is copied in large runs. Other types
+// can be supported by specializing `fmt::json_writer`.
+
+#include "escape.h"
+
+#if FMT_CPLUSPLUS >= 201703L && FMT_HAS_INCLUDE(<optional>)
+#  include <optional>
+#  define FMT_JSON_OPTIONAL 1
+#else
+#  define FMT_JSON_OPTIONAL 0
+#endif
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+// Returns true if any byte of `w` is a control character, '"' or '\'.
+inline auto json_needs_escape(size_t w) -> bool {
+  return has_byte_less(w, 0x20) || has_byte(w, '"') || has_byte(w, '\\');
+}
+
+inline auto is_json_escape(char c) -> bool {
+  return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+// Returns a pointer to the first character in [begin, end) that must be
+// escaped or end if there is none.
+inline auto find_json_escape(const char* begin, const char* end)
+    -> const char* {
+  return find_special(
+      string_view(begin, to_unsigned(end - begin)),
+      [](size_t w) { return json_needs_escape(w); },
+      [](char c) { return is_json_escape(c); });
+}
+
+inline auto write_json_string(appender out, string_view s) -> appender {
+  *out++ = '"';
+  auto begin = s.begin(), end = s.end();
+  for (;;) {
+    auto p = find_json_escape(begin, end);
+    out = copy<char>(begin, p, out);
+    if (p == end) break;
+    char c = *p;
+    begin = p + 1;
+    *out++ = '\\';
+    switch (c) {
+    case '"':
+    case '\\':
+      *out++ = c;
+      break;
+    case '\b':
+      *out++ = 'b';
+      break;
+    case '\f':
+      *out++ = 'f';
+      break;
+    case '\n':
+      *out++ = 'n';
+      break;
+    case '\r':
+      *out++ = 'r';
+      break;
+    case '\t':
+      *out++ = 't';
+      break;
+    default: {
+      char code[] = {'u', '0', '0', "0123456789abcdef"[(c >> 4) & 0xf],
+                     "0123456789abcdef"[c & 0xf]};
+      out = copy<char>(code, code + sizeof(code), out);
+    }
+    }
+  }
+  *out++ = '"';
+  return out;
+}
+
+template <typename T>
+using is_json_string =
+    bool_constant<std::is_convertible<const T&, string_view>::value ||
+                  std::is_same<T, String>::value>;
+
+template <typename T>
+auto to_json_string_view(const T& s) -> string_view {
+  return s;
+}
+inline auto to_json_string_view(const String& s) -> string_view {
+  return {s.c_str(), s.length()};
+}
+
+template <typename T, FMT_ENABLE_IF(std::is_pointer<T>::value)>
+auto is_null_json_string(T s) -> bool {
+  return s == nullptr;
+}
+template <typename T, FMT_ENABLE_IF(!std::is_pointer<T>::value)>
+auto is_null_json_string(const T&) -> bool {
+  return false;
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/**
+ * Writes values of type `T` as JSON. Specialize it to support other types,
+ * e.g. by writing an object with the members of a struct:
+ *
+ *     template <> struct fmt::json_writer<point> {
+ *       static auto write(fmt::appender out, const point& p) -> fmt::appender {
+ *         return fmt::format_to(out, R"({{"x":{},"y":{}}})", p.x, p.y);
+ *       }
+ *     };
+ */
+template <typename T, typename Enable = void> struct json_writer;
+
+/// A value formatted as JSON, see `fmt::json`.
+template <typename T> struct json_view {
+  const T& value;
+};
+
+/// Returns a view that formats `value` as JSON.
+template <typename T> auto json(const T& value) -> json_view<T> {
+  return {value};
+}
+
+template <typename T>
+auto write_json(appender out, const T& value) -> appender {
+  return json_writer<remove_cvref_t<T>>::write(out, value);
+}
+
+template <> struct json_writer<bool> {
+  static auto write(appender out, bool value) -> appender {
+    return value ? detail::write<char>(out, string_view("true"))
+                 : detail::write<char>(out, string_view("false"));
+  }
+};
+
+template <> struct json_writer<std::nullptr_t> {
+  static auto write(appender out, std::nullptr_t) -> appender {
+    return detail::write<char>(out, string_view("null"));
+  }
+};
+
+template <> struct json_writer<char> {
+  static auto write(appender out, char value) -> appender {
+    return detail::write_json_string(out, string_view(&value, 1));
+  }
+};
+
+template <typename T>
+struct json_writer<T, enable_if_t<std::is_integral<T>::value &&
+                                  !std::is_same<T, bool>::value &&
+                                  !std::is_same<T, char>::value>> {
+  static auto write(appender out, T value) -> appender {
+    return detail::write<char>(out, value);
+  }
+};
+
+template <typename T>
+struct json_writer<T, enable_if_t<std::is_floating_point<T>::value>> {
+  static auto write(appender out, T value) -> appender {
+    if (!detail::isfinite(value))
+      return detail::write<char>(out, string_view("null"));
+    return detail::write<char>(out, value);
+  }
+};
+
+template <typename T>
+struct json_writer<T, enable_if_t<detail::is_json_string<T>::value &&
+                                  !std::is_same<T, std::nullptr_t>::value>> {
+  static auto write(appender out, const T& value) -> appender {
+    if (detail::is_null_json_string<T>(value))
+      return detail::write<char>(out, string_view("null"));
+    return detail::write_json_string(out, detail::to_json_string_view(value));
+  }
+};
+
+template <typename T>
+struct json_writer<T, enable_if_t<detail::is_map<T>::value &&
+                                  !detail::is_json_string<T>::value>> {
+  static auto write(appender out, const T& map) -> appender {
+    *out++ = '{';
+    bool first = true;
+    for (const auto& entry : map) {
+      if (!first) *out++ = ',';
+      first = false;
+      using key_type = remove_cvref_t<decltype(entry.first)>;
+      static_assert(detail::is_json_string<key_type>::value ||
+                        std::is_arithmetic<key_type>::value,
+                    "JSON object keys must be strings or numbers");
+      if (detail::is_json_string<key_type>::value ||
+          std::is_same<key_type, char>::value) {
+        out = write_json(out, entry.first);
+      } else {
+        // Object keys are strings; numeric keys are quoted.
+        *out++ = '"';
+        out = write_json(out, entry.first);
+        *out++ = '"';
+      }
+      *out++ = ':';
+      out = write_json(out, entry.second);
+    }
+    *out++ = '}';
+    return out;
+  }
+};
+
+template <typename T>
+struct json_writer<T, enable_if_t<is_range<T, char>::value &&
+                                  !detail::is_map<T>::value &&
+                                  !detail::is_json_string<T>::value>> {
+  static auto write(appender out, const T& range) -> appender {
+    *out++ = '[';
+    bool first = true;
+    for (const auto& element : range) {
+      if (!first) *out++ = ',';
+      first = false;
+      out = write_json(out, element);
+    }
+    *out++ = ']';
+    return out;
+  }
+};
+
+template <typename T>
+struct json_writer<T, enable_if_t<is_tuple_like<T>::value>> {
+  static auto write(appender out, const T& tuple) -> appender {
+    *out++ = '[';
+    bool first = true;
+    detail::for_each(tuple, [&](const auto& element) {
+      if (!first) *out++ = ',';
+      first = false;
+      out = write_json(out, element);
+    });
+    *out++ = ']';
+    return out;
+  }
+};
+
+#if FMT_JSON_OPTIONAL
+template <typename T> struct json_writer<std::optional<T>> {
+  static auto write(appender out, const std::optional<T>& value)
+      -> appender {
+    if (!value) return detail::write<char>(out, string_view("null"));
+    return write_json(out, *value);
+  }
+};
+#endif
+
+template <typename T> struct json_writer<json_view<T>> {
+  static auto write(appender out, const json_view<T>& view) -> appender {
+    return write_json(out, view.value);
+  }
+};
+
+template <typename T> struct formatter<json_view<T>> {
+  FMT_CONSTEXPR auto parse(format_parse_context& ctx) -> const char* {
+    auto it = ctx.begin();
+    if (it != ctx.end() && *it != '}') report_error("invalid format specifier");
+    return it;
+  }
+
+  auto format(const json_view<T>& view, format_context& ctx) const
+      -> format_context::iterator {
+    return write_json(ctx.out(), view.value);
+  }
+};
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
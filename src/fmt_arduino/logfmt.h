@@ -0,0 +1,135 @@
+#pragma once
+
+// Structured log lines in logfmt.
+//
+// Log aggregators such as Loki and Heroku parse lines of `key=value` pairs
+// where values containing spaces, '=' or '"' are quoted. `fmt::logfmt` takes
+// named arguments and writes them as such a line:
+//
+//     using namespace fmt::literals;
+//     fmt::print("{}\n", fmt::logfmt("level"_a = "info", "t"_a = millis(),
+//                                    "msg"_a = "sensor ready"));
+//     // level=info t=1234 msg="sensor ready"
+//
+// Each value is formatted with the default format into a small buffer on the
+// stack and then scanned a machine word at a time; only values that need it
+// are quoted and escaped in place before they are copied to the output. The
+// names come from the named argument table that `fmt::arg` and the `_a`
+// literals already build for format strings with named arguments, so no extra
+// storage is needed. Keys are written as given.
+
+#include "escape.h"
+
+#include <tuple>
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+inline auto is_logfmt_special(char c) -> bool {
+  return static_cast<unsigned char>(c) <= ' ' || c == '=' || c == '"';
+}
+
+// Returns true if a value must be quoted: it is empty or contains a space, a
+// control character, '=' or '"'.
+inline auto logfmt_needs_quotes(string_view value) -> bool {
+  if (value.size() == 0) return true;
+  return find_special(
+             value,
+             [](size_t w) {
+               return has_byte_less(w, 0x21) || has_byte(w, '=') ||
+                      has_byte(w, '"');
+             },
+             [](char c) { return is_logfmt_special(c); }) != value.end();
+}
+
+// Returns the length of the escape sequence for `c` inside quotes or 1.
+inline auto logfmt_escape_size(char c) -> size_t {
+  if (c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t') return 2;
+  return static_cast<unsigned char>(c) < ' ' ? 6 : 1;
+}
+
+// Quotes and escapes the value that starts at `start` and extends to the end
+// of `buf`.
+inline void logfmt_quote(buffer<char>& buf, size_t start) {
+  auto escape_size = [](char c) { return logfmt_escape_size(c); };
+  quote_in_place(buf, start, escape_size, [](char c, char* out) {
+    out[0] = '\\';
+    if (logfmt_escape_size(c) == 2) {
+      out[1] = c == '\n' ? 'n' : c == '\r' ? 'r' : c == '\t' ? 't' : c;
+      return;
+    }
+    const char* digits = "0123456789abcdef";
+    char code[] = {'u', '0', '0', digits[(c >> 4) & 0xf], digits[c & 0xf]};
+    memcpy(out + 1, code, sizeof(code));
+  });
+}
+
+// Writes `key=value` pairs separated by spaces for the named arguments
+// `names` referring to `args`. Each value is formatted into a local buffer
+// first because `buf` may be flushed while the value is written, e.g. when it
+// writes to a sink or a `String`.
+inline void vformat_logfmt(buffer<char>& buf, const named_arg_info<char>* names,
+                           size_t num_names, format_args args) {
+  basic_memory_buffer<char, 64> value;
+  for (size_t i = 0; i < num_names; ++i) {
+    if (i != 0) buf.push_back(' ');
+    auto name = string_view(names[i].name);
+    buf.append(name.begin(), name.end());
+    buf.push_back('=');
+    value.clear();
+    args.get(names[i].id).visit(default_arg_formatter<char>{appender(value)});
+    if (logfmt_needs_quotes(string_view(value.data(), value.size())))
+      logfmt_quote(value, 0);
+    buf.append(value.data(), value.data() + value.size());
+  }
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// Named arguments formatted as a logfmt line, see `fmt::logfmt`.
+template <typename... T> struct logfmt_view {
+  std::tuple<T...> args;
+};
+
+/**
+ * Returns a view that formats the named arguments `args`, created with
+ * `fmt::arg` or the `_a` literals, as `key=value` pairs separated by spaces.
+ * Like `fmt::arg` it should only be used in a call to a formatting function.
+ */
+template <typename... T>
+auto logfmt(const T&... args) -> logfmt_view<T...> {
+  static_assert(sizeof...(T) > 0, "logfmt needs at least one argument");
+  static_assert(detail::count_named_args<T...>() == sizeof...(T),
+                "all arguments of logfmt must be named");
+  return {std::tuple<T...>(args...)};
+}
+
+template <typename... T> struct formatter<logfmt_view<T...>> {
+ private:
+  template <size_t... Is>
+  static void write(detail::buffer<char>& buf, const logfmt_view<T...>& view,
+                    detail::index_sequence<Is...>) {
+    auto store = vargs<T...>{{std::get<Is>(view.args)...}};
+    detail::vformat_logfmt(buf, store.args.named_args, sizeof...(T), store);
+  }
+
+ public:
+  FMT_CONSTEXPR auto parse(format_parse_context& ctx) -> const char* {
+    auto it = ctx.begin();
+    if (it != ctx.end() && *it != '}') report_error("invalid format specifier");
+    return it;
+  }
+
+  auto format(const logfmt_view<T...>& view, format_context& ctx) const
+      -> format_context::iterator {
+    auto out = ctx.out();
+    write(detail::get_container(out), view,
+          detail::make_index_sequence<sizeof...(T)>());
+    return out;
+  }
+};
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
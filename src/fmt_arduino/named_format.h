@@ -0,0 +1,281 @@
+#pragma once
+
+// Pre-parsed format strings with named arguments resolved to positional ids.
+//
+// `basic_format_args::get_id` looks up `{name}` fields by comparing the name
+// against every named argument, on every replacement field of every call.
+// `named_format` does this resolution once: names are looked up through a
+// hash index when the object is constructed and the format string is rewritten
+// to use positional ids only, so formatting it costs the same as a format
+// string without names.
+//
+// For formats known at compile time `FMT_COMPILE` together with the `_a`
+// literals already resolves names during compilation (see fmt/compile.h).
+
+#include "../fmt.h"
+
+#include <initializer_list>
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+// FNV-1a hash of an argument name.
+template <typename Char>
+FMT_CONSTEXPR auto name_hash(basic_string_view<Char> name) -> uint32_t {
+  uint32_t h = 0x811c9dc5u;
+  for (Char c : name) {
+    h ^= static_cast<uint32_t>(c);
+    h *= 0x01000193u;
+  }
+  return h;
+}
+
+// An open addressing hash table mapping argument names to argument ids.
+template <typename Char> class named_arg_index {
+ private:
+  struct entry {
+    basic_string_view<Char> name;
+    uint32_t hash;
+    int id;  // -1 for an empty slot.
+  };
+
+  enum { inline_slots = 32 };
+  basic_memory_buffer<entry, inline_slots> slots_;
+  size_t mask_;
+
+ public:
+  explicit named_arg_index(size_t num_names) {
+    size_t capacity = inline_slots;
+    while (capacity < num_names * 2) capacity *= 2;
+    slots_.resize(capacity);
+    for (auto& slot : slots_) slot.id = -1;
+    mask_ = capacity - 1;
+  }
+
+  void insert(basic_string_view<Char> name, int id) {
+    auto hash = name_hash(name);
+    size_t i = hash & mask_;
+    while (slots_[i].id >= 0) {
+      if (slots_[i].hash == hash && slots_[i].name == name)
+        report_error("duplicate named arg");
+      i = (i + 1) & mask_;
+    }
+    slots_[i] = {name, hash, id};
+  }
+
+  auto find(basic_string_view<Char> name) const -> int {
+    auto hash = name_hash(name);
+    for (size_t i = hash & mask_; slots_[i].id >= 0; i = (i + 1) & mask_) {
+      if (slots_[i].hash == hash && slots_[i].name == name)
+        return slots_[i].id;
+    }
+    return -1;
+  }
+};
+
+// Rewrites a format string replacing automatic and named argument ids with
+// positional ones. Like `parse_context` it rejects format strings that switch
+// between automatic and manual indexing.
+template <typename Char> class named_format_rewriter {
+ private:
+  buffer<Char>& out_;
+  const named_arg_index<Char>& index_;
+  int next_arg_id_ = 0;  // -1 once a manual or named id has been used.
+
+  void write_id(int id) {
+    write<Char>(basic_appender<Char>(out_), id);
+  }
+
+ public:
+  named_format_rewriter(buffer<Char>& out, const named_arg_index<Char>& index)
+      : out_(out), index_(index) {}
+
+  void on_text(const Char* begin, const Char* end) {
+    // parse_format_string passes unescaped text so braces are escaped again.
+    for (; begin != end; ++begin) {
+      if (*begin == '{' || *begin == '}') out_.push_back(*begin);
+      out_.push_back(*begin);
+    }
+  }
+
+  auto on_arg_id() -> int {
+    if (next_arg_id_ < 0)
+      report_error("cannot switch from manual to automatic argument indexing");
+    return next_arg_id_++;
+  }
+  auto on_arg_id(int id) -> int {
+    if (next_arg_id_ > 0)
+      report_error("cannot switch from automatic to manual argument indexing");
+    next_arg_id_ = -1;
+    return id;
+  }
+  auto on_arg_id(basic_string_view<Char> name) -> int {
+    next_arg_id_ = -1;
+    int id = index_.find(name);
+    if (id < 0) report_error("argument not found");
+    return id;
+  }
+
+  void on_replacement_field(int id, const Char*) {
+    out_.push_back('{');
+    write_id(id);
+    out_.push_back('}');
+  }
+
+  auto on_format_specs(int id, const Char* begin, const Char* end)
+      -> const Char* {
+    out_.push_back('{');
+    write_id(id);
+    out_.push_back(':');
+    while (begin != end && *begin != '}') {
+      if (*begin != '{') {
+        out_.push_back(*begin++);
+        continue;
+      }
+      // A dynamic width or precision such as `{:{width}}`.
+      struct id_adapter {
+        named_format_rewriter& self;
+        int arg_id;
+
+        void on_index(int i) { arg_id = self.on_arg_id(i); }
+        void on_name(basic_string_view<Char> name) {
+          arg_id = self.on_arg_id(name);
+        }
+      } adapter = {*this, 0};
+      ++begin;
+      if (begin != end && *begin == '}')
+        adapter.arg_id = on_arg_id();
+      else
+        begin = parse_arg_id(begin, end, adapter);
+      if (begin == end || *begin != '}')
+        report_error("invalid format string");
+      ++begin;
+      out_.push_back('{');
+      write_id(adapter.arg_id);
+      out_.push_back('}');
+    }
+    out_.push_back('}');
+    return begin;
+  }
+
+  FMT_NORETURN void on_error(const char* message) { report_error(message); }
+};
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/**
+ * A format string with all argument ids resolved to positions. Names are given
+ * in the order the arguments are passed:
+ *
+ *     static const fmt::named_format payload(
+ *         "{{\"t\":{temp:.1f},\"h\":{hum}}}", {"temp", "hum"});
+ *     std::string s = fmt::format(payload, fmt::arg("temp", t),
+ *                                 fmt::arg("hum", h));
+ *
+ * Since ids are positional the arguments can also be passed without names.
+ * An empty name marks a positional-only argument.
+ */
+template <typename Char> class basic_named_format {
+ private:
+  basic_memory_buffer<Char, 64> str_;
+  // The names, each followed by a null character, to check the arguments.
+  basic_memory_buffer<Char, 32> names_;
+  basic_memory_buffer<size_t, 8> name_offsets_;  // The start of each name.
+
+  auto name(size_t id) const -> basic_string_view<Char> {
+    if (id >= name_offsets_.size()) return {};
+    return names_.data() + name_offsets_[id];
+  }
+
+  template <typename T, FMT_ENABLE_IF(!detail::is_named_arg<T>::value)>
+  void check_arg(size_t, const T&) const {}
+
+  template <typename T, FMT_ENABLE_IF(detail::is_named_arg<T>::value)>
+  void check_arg(size_t id, const T& arg) const {
+    auto arg_name = basic_string_view<Char>(arg.name);
+    if (name(id) == arg_name) return;
+    // Only a mismatch searches the names.
+    for (size_t i = 0; i < name_offsets_.size(); ++i) {
+      if (name(i) == arg_name)
+        report_error("named argument passed out of order");
+    }
+  }
+
+ public:
+  /**
+   * Resolves the names in `fmt` to their positions in `names`. Arguments must
+   * be passed in the same order as `names` since they are only matched by
+   * position when formatting; named arguments passed at a different position
+   * are reported as an error.
+   */
+  basic_named_format(basic_string_view<Char> fmt,
+                     std::initializer_list<basic_string_view<Char>> names) {
+    auto index = detail::named_arg_index<Char>(names.size());
+    int id = 0;
+    for (auto name : names) {
+      if (name.size() != 0) index.insert(name, id);
+      name_offsets_.push_back(names_.size());
+      names_.append(name.begin(), name.end());
+      names_.push_back(Char());
+      ++id;
+    }
+    detail::parse_format_string(
+        fmt, detail::named_format_rewriter<Char>(str_, index));
+  }
+
+  /// Reports an error if a named argument in `args` is not at the position of
+  /// its name. This compares the name of each named argument with the name at
+  /// its position, so it costs one string comparison per named argument.
+  template <typename... T> void check_args(const T&... args) const {
+    size_t id = 0;
+    FMT_APPLY_VARIADIC(check_arg(id++, args));
+    detail::ignore_unused(id);
+  }
+
+  /// Returns the rewritten format string.
+  auto str() const -> basic_string_view<Char> {
+    return {str_.data(), str_.size()};
+  }
+};
+
+using named_format = basic_named_format<char>;
+
+template <typename... T>
+FMT_NODISCARD auto format(const named_format& fmt, T&&... args)
+    -> std::string {
+  fmt.check_args(args...);
+  auto store = fmt::make_format_args(args...);
+  return vformat(fmt.str(), store);
+}
+
+template <typename OutputIt, typename... T,
+          FMT_ENABLE_IF(detail::is_output_iterator<remove_cvref_t<OutputIt>,
+                                                   char>::value)>
+auto format_to(OutputIt&& out, const named_format& fmt, T&&... args)
+    -> remove_cvref_t<OutputIt> {
+  fmt.check_args(args...);
+  auto store = fmt::make_format_args(args...);
+  return vformat_to(out, fmt.str(), store);
+}
+
+template <size_t N, typename... T>
+auto format_to(char (&out)[N], const named_format& fmt, T&&... args)
+    -> format_to_result {
+  fmt.check_args(args...);
+  auto store = fmt::make_format_args(args...);
+  return vformat_to(out, fmt.str(), store);
+}
+
+template <typename OutputIt, typename... T,
+          FMT_ENABLE_IF(detail::is_output_iterator<OutputIt, char>::value)>
+auto format_to_n(OutputIt out, size_t n, const named_format& fmt,
+                 T&&... args) -> format_to_n_result<OutputIt> {
+  fmt.check_args(args...);
+  auto store = fmt::make_format_args(args...);
+  return vformat_to_n(out, n, fmt.str(), store);
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
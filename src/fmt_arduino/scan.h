@@ -0,0 +1,516 @@
+#pragma once
+
+// Parsing text with format strings.
+//
+// Commands read from Serial are usually parsed with `Stream::parseInt` and
+// `parseFloat`, which block on timeouts and can't report what didn't match, or
+// with `sscanf`, which is large and, on AVR, has no floating point support by
+// default. `fmt::scan` uses the replacement field syntax of format strings:
+//
+//     int channel;
+//     unsigned mask;
+//     float level;
+//     auto result = fmt::scan(line, "SET {} {:x} {}", channel, mask, level);
+//     if (!result) Serial.println("usage: SET <channel> <mask> <level>");
+//
+// Fields are parsed by the same `parse_format_string` and `parse_format_specs`
+// as format strings. The supported specifiers are a width, which limits the
+// number of characters a field consumes, and the presentation types `d`, `x`,
+// `b` and `o` for integers (a `0x` or `0b` prefix is accepted with `x` and
+// `b`), `e` (an exponent is required), `f` (no exponent) and `g` (the
+// default) for floating point numbers, `s` for strings and `c` for characters.
+// Hexadecimal floating point numbers (`a`) are not supported. As in `scanf`,
+// fields other than characters skip leading whitespace and whitespace in the
+// format string matches any amount of whitespace, including none. Other text
+// must match exactly. Strings end at whitespace or at the character that
+// follows the field in the format string, so "{}={}" splits "speed=42".
+//
+// Arguments can be integers, `float`, `double`, `char`, `fmt::string_view`
+// (a view of the input) and `char` arrays (a null-terminated copy). Numbers
+// are parsed with `fmt::from_chars`, so floating point numbers are rounded
+// correctly without `strtod`. Nothing is allocated. With C++20 the format
+// string is checked at compile time.
+
+#include "from_chars.h"
+
+FMT_BEGIN_NAMESPACE
+
+/// Error codes of `fmt::scan`.
+enum class scan_errc : unsigned char {
+  ok = 0,
+  /// The input doesn't match the format string.
+  invalid_input,
+  /// A number doesn't fit its argument or a string doesn't fit its array.
+  out_of_range,
+};
+
+namespace detail {
+
+enum class scan_type : unsigned char {
+  none,
+  signed_int,
+  unsigned_int,
+  floating,
+  char_type,
+  string_view_type,
+  char_array
+};
+
+template <typename T, typename Enable = void>
+struct scan_type_constant
+    : std::integral_constant<scan_type, scan_type::none> {};
+
+template <typename T>
+struct scan_type_constant<
+    T, enable_if_t<std::is_integral<T>::value &&
+                   !std::is_same<T, bool>::value &&
+                   !std::is_same<T, char>::value>>
+    : std::integral_constant<scan_type, std::is_signed<T>::value
+                                            ? scan_type::signed_int
+                                            : scan_type::unsigned_int> {};
+
+template <> struct scan_type_constant<float>
+    : std::integral_constant<scan_type, scan_type::floating> {};
+template <> struct scan_type_constant<double>
+    : std::integral_constant<scan_type, scan_type::floating> {};
+template <> struct scan_type_constant<char>
+    : std::integral_constant<scan_type, scan_type::char_type> {};
+template <> struct scan_type_constant<string_view>
+    : std::integral_constant<scan_type, scan_type::string_view_type> {};
+template <size_t N> struct scan_type_constant<char[N]>
+    : std::integral_constant<scan_type, scan_type::char_array> {};
+
+// Returns the formatting argument type whose specs are valid for `t`.
+FMT_CONSTEXPR inline auto to_format_type(scan_type t) -> type {
+  switch (t) {
+  case scan_type::signed_int:
+    return type::long_long_type;
+  case scan_type::unsigned_int:
+    return type::ulong_long_type;
+  case scan_type::floating:
+    return type::double_type;
+  case scan_type::char_type:
+    return type::char_type;
+  case scan_type::string_view_type:
+  case scan_type::char_array:
+    return type::string_type;
+  default:
+    return type::none_type;
+  }
+}
+
+struct scan_specs {
+  int width;
+  presentation_type type;
+};
+
+// Parses format specs of a field of type `t` keeping only those that apply to
+// scanning.
+FMT_CONSTEXPR inline auto parse_scan_specs(const char* begin, const char* end,
+                                           scan_specs& specs,
+                                           parse_context<char>& ctx,
+                                           scan_type t) -> const char* {
+  auto fs = dynamic_format_specs<>();
+  auto it = parse_format_specs(begin, end, fs, ctx, to_format_type(t));
+  bool is_int = t == scan_type::signed_int || t == scan_type::unsigned_int;
+  // Floating point presentation types share values with the other ones.
+  bool is_float = t == scan_type::floating;
+  if (fs.align() != align::none || fs.sign() != sign::none || fs.alt() ||
+      fs.localized() || fs.precision >= 0 ||
+      fs.dynamic_width() != arg_id_kind::none ||
+      fs.dynamic_precision() != arg_id_kind::none ||
+      (!is_float && fs.type() == presentation_type::debug) ||
+      (is_float && fs.type() == presentation_type::hexfloat) ||
+      (is_int && fs.type() == presentation_type::chr)) {
+    report_error("invalid scan specifier");
+  }
+  specs = {fs.width, fs.type()};
+  return it;
+}
+
+// Checks a scan format string at compile time.
+template <int NUM_ARGS> class scan_string_checker {
+ private:
+  scan_type types_[max_of(1, NUM_ARGS)];
+  type format_types_[max_of(1, NUM_ARGS)];
+  compile_parse_context<char> context_;
+
+ public:
+  template <typename... T>
+  FMT_CONSTEXPR explicit scan_string_checker(string_view fmt, arg_pack<T...>)
+      : types_{scan_type_constant<T>::value...},
+        format_types_{to_format_type(scan_type_constant<T>::value)...},
+        context_(fmt, NUM_ARGS, format_types_) {}
+
+  FMT_CONSTEXPR void on_text(const char*, const char*) {}
+
+  FMT_CONSTEXPR auto on_arg_id() -> int { return context_.next_arg_id(); }
+  FMT_CONSTEXPR auto on_arg_id(int id) -> int {
+    context_.check_arg_id(id);
+    return id;
+  }
+  FMT_CONSTEXPR auto on_arg_id(string_view) -> int {
+    on_error("named arguments are not supported by scan");
+    return 0;
+  }
+
+  FMT_CONSTEXPR void on_replacement_field(int, const char*) {}
+
+  FMT_CONSTEXPR auto on_format_specs(int id, const char* begin,
+                                     const char* end) -> const char* {
+    context_.advance_to(begin);
+    auto specs = scan_specs();
+    return parse_scan_specs(begin, end, specs, context_, types_[id]);
+  }
+
+  FMT_NORETURN FMT_CONSTEXPR void on_error(const char* message) {
+    report_error(message);
+  }
+};
+
+struct scan_arg {
+  scan_type type;
+  unsigned char size;  // The size of integers and floating point numbers.
+  size_t capacity;     // The size of char arrays.
+  void* value;
+};
+
+template <typename T> auto make_scan_arg(T& value) -> scan_arg {
+  static_assert(scan_type_constant<T>::value != scan_type::none,
+                "cannot scan this type; use an integer, float, double, char, "
+                "fmt::string_view or char array");
+  static_assert(!std::is_integral<T>::value || sizeof(T) <= 8,
+                "integers wider than 64 bits cannot be scanned");
+  return {scan_type_constant<T>::value,
+          static_cast<unsigned char>(sizeof(T) <= 8 ? sizeof(T) : 0), sizeof(T),
+          &value};
+}
+
+inline auto is_scan_space(char c) -> bool {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+template <typename Int> void store_int(void* p, Int value) {
+  memcpy(p, &value, sizeof(value));
+}
+
+class scan_handler {
+ private:
+  const char* it_;
+  const char* end_;
+  const scan_arg* args_;
+  int num_args_;
+  parse_context<char> context_;
+  int count_ = 0;
+  scan_errc ec_ = scan_errc::ok;
+
+  // Returns the literal character that follows a field or 0.
+  auto terminator(const char* next) const -> char {
+    if (next == context_.end() || *next == '{' || is_scan_space(*next))
+      return 0;
+    return *next;
+  }
+
+  void fail(scan_errc ec) {
+    if (ec_ == scan_errc::ok) ec_ = ec;
+  }
+
+  auto field_end(int width) const -> const char* {
+    return width > 0 && to_unsigned(width) < to_unsigned(end_ - it_)
+               ? it_ + width
+               : end_;
+  }
+
+  auto scan_int(const scan_arg& arg, const scan_specs& specs) -> bool {
+    auto end = field_end(specs.width);
+    auto p = it_;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    unsigned base = 10;
+    char prefix = 0;
+    switch (specs.type) {
+    case presentation_type::hex:
+      base = 16;
+      prefix = 'x';
+      break;
+    case presentation_type::bin:
+      base = 2;
+      prefix = 'b';
+      break;
+    case presentation_type::oct:
+      base = 8;
+      break;
+    default:
+      break;
+    }
+    if (prefix && end - p > 2 && p[0] == '0' && (p[1] | 0x20) == prefix &&
+        digit_value(p[2]) < base) {
+      p += 2;
+    }
+    auto digits = p;
+    unsigned long long value = 0;
+    bool overflow = false;
+    p = parse_unsigned(p, end, base, max_value<unsigned long long>(), value,
+                       overflow);
+    if (p == digits) return false;
+    it_ = p;
+    unsigned bits = arg.size * 8u;
+    if (arg.type == scan_type::unsigned_int) {
+      auto max = max_value<unsigned long long>() >> (64 - bits);
+      if (overflow || value > max || (negative && value != 0))
+        return fail(scan_errc::out_of_range), false;
+      switch (arg.size) {
+      case 1:
+        return store_int(arg.value, static_cast<uint8_t>(value)), true;
+      case 2:
+        return store_int(arg.value, static_cast<uint16_t>(value)), true;
+      case 4:
+        return store_int(arg.value, static_cast<uint32_t>(value)), true;
+      }
+      return store_int(arg.value, static_cast<uint64_t>(value)), true;
+    }
+    // The magnitude of the most negative value.
+    auto limit = 1ull << (bits - 1);
+    if (overflow || value > limit || (!negative && value == limit))
+      return fail(scan_errc::out_of_range), false;
+    auto signed_value = static_cast<long long>(negative ? 0 - value : value);
+    switch (arg.size) {
+    case 1:
+      return store_int(arg.value, static_cast<int8_t>(signed_value)), true;
+    case 2:
+      return store_int(arg.value, static_cast<int16_t>(signed_value)), true;
+    case 4:
+      return store_int(arg.value, static_cast<int32_t>(signed_value)), true;
+    }
+    return store_int(arg.value, static_cast<int64_t>(signed_value)), true;
+  }
+
+  template <typename T>
+  auto scan_float(void* value, const char* begin, const char* end,
+                  chars_format fmt) -> from_chars_result {
+    T f;
+    auto result = fmt::from_chars(begin, end, f, fmt);
+    if (result) memcpy(value, &f, sizeof(f));
+    return result;
+  }
+
+  auto scan_float(const scan_arg& arg, const scan_specs& specs) -> bool {
+    auto end = field_end(specs.width);
+    auto p = it_;
+    // from_chars doesn't accept a plus sign.
+    if (p != end && *p == '+') {
+      ++p;
+      if (p != end && *p == '-') return false;
+    }
+    auto fmt = chars_format::general;
+    if (specs.type == presentation_type::exp)
+      fmt = chars_format::scientific;
+    else if (specs.type == presentation_type::fixed)
+      fmt = chars_format::fixed;
+    auto result = arg.size == sizeof(float)
+                      ? scan_float<float>(arg.value, p, end, fmt)
+                      : scan_float<double>(arg.value, p, end, fmt);
+    if (result.ec == std::errc::invalid_argument) return false;
+    it_ = result.ptr;
+    if (!result) return fail(scan_errc::out_of_range), false;
+    return true;
+  }
+
+  // Scans a string that ends before whitespace or `terminator`.
+  auto scan_string(const scan_arg& arg, const scan_specs& specs,
+                   char terminator) -> bool {
+    auto end = field_end(specs.width);
+    auto p = it_;
+    while (p != end && !is_scan_space(*p) && *p != terminator) ++p;
+    if (p == it_) return false;
+    size_t size = to_unsigned(p - it_);
+    if (arg.type == scan_type::string_view_type) {
+      *static_cast<string_view*>(arg.value) = string_view(it_, size);
+    } else {
+      if (size >= arg.capacity) return fail(scan_errc::out_of_range), false;
+      auto s = static_cast<char*>(arg.value);
+      memcpy(s, it_, size);
+      s[size] = '\0';
+    }
+    it_ = p;
+    return true;
+  }
+
+  // Scans argument `id`; `next` points to the format string after the field.
+  void scan(int id, const scan_specs& specs, const char* next) {
+    if (id >= num_args_) report_error("argument not found");
+    if (ec_ != scan_errc::ok) return;
+    const scan_arg& arg = args_[id];
+    if (arg.type != scan_type::char_type) {
+      while (it_ != end_ && is_scan_space(*it_)) ++it_;
+    }
+    bool ok = false;
+    switch (arg.type) {
+    case scan_type::signed_int:
+    case scan_type::unsigned_int:
+      ok = scan_int(arg, specs);
+      break;
+    case scan_type::floating:
+      ok = scan_float(arg, specs);
+      break;
+    case scan_type::char_type:
+      if (it_ != end_) {
+        *static_cast<char*>(arg.value) = *it_++;
+        ok = true;
+      }
+      break;
+    case scan_type::string_view_type:
+    case scan_type::char_array:
+      ok = scan_string(arg, specs, terminator(next));
+      break;
+    case scan_type::none:
+      break;
+    }
+    if (ok)
+      ++count_;
+    else
+      fail(scan_errc::invalid_input);
+  }
+
+ public:
+  scan_handler(string_view input, string_view fmt, const scan_arg* args,
+               int num_args)
+      : it_(input.begin()),
+        end_(input.end()),
+        args_(args),
+        num_args_(num_args),
+        context_(fmt) {}
+
+  void on_text(const char* begin, const char* end) {
+    for (; begin != end && ec_ == scan_errc::ok; ++begin) {
+      if (is_scan_space(*begin)) {
+        while (it_ != end_ && is_scan_space(*it_)) ++it_;
+      } else if (it_ != end_ && *it_ == *begin) {
+        ++it_;
+      } else {
+        fail(scan_errc::invalid_input);
+      }
+    }
+  }
+
+  auto on_arg_id() -> int { return context_.next_arg_id(); }
+  auto on_arg_id(int id) -> int {
+    context_.check_arg_id(id);
+    return id;
+  }
+  auto on_arg_id(string_view) -> int {
+    on_error("named arguments are not supported by scan");
+    return 0;
+  }
+
+  void on_replacement_field(int id, const char* p) {
+    scan(id, scan_specs{0, presentation_type::none}, p + 1);
+  }
+
+  auto on_format_specs(int id, const char* begin, const char* end)
+      -> const char* {
+    if (id >= num_args_) report_error("argument not found");
+    context_.advance_to(begin);
+    auto specs = scan_specs();
+    begin = parse_scan_specs(begin, end, specs, context_, args_[id].type);
+    scan(id, specs, begin != end ? begin + 1 : end);
+    return begin;
+  }
+
+  FMT_NORETURN void on_error(const char* message) { report_error(message); }
+
+  auto position() const -> const char* { return it_; }
+  auto count() const -> int { return count_; }
+  auto error() const -> scan_errc { return ec_; }
+};
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// The result of `fmt::scan`.
+struct scan_result {
+  /// Pointer past the last character of the input that was consumed.
+  const char* end;
+  /// The number of arguments that were assigned.
+  int count;
+  scan_errc ec;
+
+  explicit operator bool() const noexcept { return ec == scan_errc::ok; }
+};
+
+/// A scan format string checked at compile time with C++20.
+template <typename... T> struct scan_fstring {
+ private:
+  using checker = detail::scan_string_checker<static_cast<int>(sizeof...(T))>;
+
+ public:
+  string_view str;
+  using t = scan_fstring;
+
+  template <size_t N>
+  FMT_CONSTEVAL FMT_ALWAYS_INLINE scan_fstring(const char (&s)[N])
+      : str(s, N - 1) {
+    if (FMT_USE_CONSTEVAL)
+      detail::parse_format_string<char>(
+          str, checker(str, detail::arg_pack<T...>()));
+  }
+  scan_fstring(runtime_format_string<> fmt) : str(fmt.str) {}
+
+  FMT_ALWAYS_INLINE operator const string_view&() const { return str; }
+};
+
+template <typename... T>
+using scan_string = typename scan_fstring<remove_cvref_t<T>...>::t;
+
+/// Type-erased scan arguments, see `fmt::vscan`.
+struct scan_args {
+  const detail::scan_arg* data;
+  int size;
+};
+
+/// Scans `input` according to `fmt` storing values in `args`. An invalid
+/// format string is reported like in formatting functions; input that doesn't
+/// match is reported in the result.
+inline auto vscan(string_view input, string_view fmt, scan_args args)
+    -> scan_result {
+  auto handler = detail::scan_handler(input, fmt, args.data, args.size);
+  detail::parse_format_string(fmt, handler);
+  return {handler.position(), handler.count(), handler.error()};
+}
+
+/**
+ * Scans `input` according to the format string `fmt` and stores the parsed
+ * values in `args`. Scanning stops at the first mismatch; arguments after it
+ * are left unchanged:
+ *
+ *     fmt::string_view name;
+ *     int value = 0;
+ *     if (fmt::scan("speed=42", "{}={}", name, value)) ...
+ */
+template <typename... T>
+auto scan(string_view input, scan_string<T...> fmt, T&... args)
+    -> scan_result {
+  detail::scan_arg store[max_of<size_t>(1, sizeof...(T))] = {
+      detail::make_scan_arg(args)...};
+  return vscan(input, fmt, {store, static_cast<int>(sizeof...(T))});
+}
+
+/**
+ * Reads a line from `in`, e.g. `Serial`, into `line` and scans it. The line
+ * ends with '\n' or when the stream times out; a trailing '\r' is removed.
+ * Characters that don't fit into `line` are left in the stream. String views
+ * point into `line`.
+ */
+template <typename Stream, size_t N, typename... T>
+auto scan_line(Stream& in, char (&line)[N], scan_string<T...> fmt,
+               T&... args) -> scan_result {
+  static_assert(N > 1, "line buffer is too small");
+  size_t size = in.readBytesUntil('\n', line, N - 1);
+  if (size != 0 && line[size - 1] == '\r') --size;
+  line[size] = '\0';
+  return scan(string_view(line, size), fmt, args...);
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
@@ -0,0 +1,195 @@
+#pragma once
+
+// A buffer made of fixed-size segments that never moves its contents.
+//
+// `basic_memory_buffer` grows by allocating a block 1.5 times larger, copying
+// the contents and freeing the old block. For multi-kilobyte output such as
+// JSON reports this copies the output several times and leaves holes of
+// growing sizes in the heap. `segmented_buffer` appends fixed-size segments
+// instead, optionally taken from a `segment_pool` that keeps them for reuse,
+// and is written out segment by segment, e.g. to a `Print` or a `FILE`.
+// Its `detail::buffer` base only ever holds the last segment, so it is private
+// and output is appended through `out()`.
+
+#include "../fmt.h"
+
+#include <stdio.h>  // FILE
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+template <size_t SIZE> struct segment {
+  segment* next;
+  char data[SIZE];
+};
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// A free list of segments shared by segmented buffers.
+template <size_t SEGMENT_SIZE = 128> class segment_pool {
+ private:
+  using segment = detail::segment<SEGMENT_SIZE>;
+
+  segment* free_ = nullptr;
+  size_t num_free_ = 0;
+
+ public:
+  segment_pool() = default;
+  /// Constructs a pool with `n` segments preallocated.
+  explicit segment_pool(size_t n) { reserve(n); }
+  segment_pool(const segment_pool&) = delete;
+  void operator=(const segment_pool&) = delete;
+
+  ~segment_pool() {
+    while (free_) {
+      auto next = free_->next;
+      detail::allocator<segment>().deallocate(free_, 1);
+      free_ = next;
+    }
+  }
+
+  /// Allocates segments until `n` are available.
+  void reserve(size_t n) {
+    while (num_free_ < n) release(detail::allocator<segment>().allocate(1));
+  }
+
+  auto acquire() -> segment* {
+    if (!free_) return detail::allocator<segment>().allocate(1);
+    auto s = free_;
+    free_ = s->next;
+    --num_free_;
+    return s;
+  }
+
+  void release(segment* s) noexcept {
+    s->next = free_;
+    free_ = s;
+    ++num_free_;
+  }
+
+  /// Returns the number of segments available without allocating.
+  auto free_segments() const noexcept -> size_t { return num_free_; }
+};
+
+/**
+ * A buffer storing its contents in a list of `SEGMENT_SIZE` character
+ * segments. Segments come from `pool` if given or the heap otherwise:
+ *
+ *     static fmt::segment_pool<> pool(8);
+ *     fmt::segmented_buffer buf(&pool);
+ *     fmt::format_to(buf.out(), "{}", readings);
+ *     buf.write_to(Serial);
+ */
+template <size_t SEGMENT_SIZE = 128>
+class basic_segmented_buffer : private detail::buffer<char> {
+ private:
+  using segment = detail::segment<SEGMENT_SIZE>;
+
+  segment_pool<SEGMENT_SIZE>* pool_;
+  segment* head_ = nullptr;
+  segment* tail_ = nullptr;
+  size_t full_size_ = 0;  // The size of the segments before the tail.
+  // The data of an empty buffer. It is never written to but keeps `data()`
+  // non-null, so that writes through `data() + size()` with a count of zero,
+  // e.g. with `memcpy`, are valid before the first segment is added.
+  char empty_[1];
+
+  static void grow(buffer<char>& buf, size_t) {
+    // Let the caller fill the current segment first.
+    if (buf.size() != buf.capacity()) return;
+    static_cast<basic_segmented_buffer&>(buf).add_segment();
+  }
+
+  void add_segment() {
+    auto s =
+        pool_ ? pool_->acquire() : detail::allocator<segment>().allocate(1);
+    s->next = nullptr;
+    if (tail_) {
+      tail_->next = s;
+      full_size_ += size();
+    } else {
+      head_ = s;
+    }
+    tail_ = s;
+    set(s->data, SEGMENT_SIZE);
+    clear();
+  }
+
+ public:
+  explicit basic_segmented_buffer(segment_pool<SEGMENT_SIZE>* pool = nullptr)
+      : buffer<char>(grow), pool_(pool) {
+    set(empty_, 0);
+  }
+  basic_segmented_buffer(const basic_segmented_buffer&) = delete;
+  void operator=(const basic_segmented_buffer&) = delete;
+  ~basic_segmented_buffer() { reset(); }
+
+  /// Returns an output iterator that appends to the buffer.
+  auto out() noexcept -> appender { return appender(*this); }
+
+  /// Returns the size of the output in all segments.
+  auto total_size() const noexcept -> size_t { return full_size_ + size(); }
+
+  /// Returns the number of segments in use.
+  auto num_segments() const noexcept -> size_t {
+    size_t n = 0;
+    for (auto s = head_; s; s = s->next) ++n;
+    return n;
+  }
+
+  /// Calls `f(string_view)` for each non-empty segment in order.
+  template <typename F> void for_each_segment(F&& f) const {
+    for (auto s = head_; s; s = s->next) {
+      size_t n = s == tail_ ? size() : SEGMENT_SIZE;
+      if (n != 0) f(string_view(s->data, n));
+    }
+  }
+
+  /// Returns the segments to the pool or the heap and empties the buffer.
+  void reset() noexcept {
+    while (head_) {
+      auto next = head_->next;
+      if (pool_)
+        pool_->release(head_);
+      else
+        detail::allocator<segment>().deallocate(head_, 1);
+      head_ = next;
+    }
+    tail_ = nullptr;
+    full_size_ = 0;
+    set(empty_, 0);
+    clear();
+  }
+
+  /// Writes the output to `p` and returns the number of bytes written.
+  auto write_to(Print& p) const -> size_t {
+    size_t written = 0;
+    for_each_segment([&](string_view s) {
+      written += p.write(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    });
+    return written;
+  }
+
+  /// Writes the output to `f` and returns the number of bytes written.
+  auto write_to(FILE* f) const -> size_t {
+    size_t written = 0;
+    for_each_segment(
+        [&](string_view s) { written += fwrite(s.data(), 1, s.size(), f); });
+    return written;
+  }
+
+  /// Copies the output to a string.
+  auto str() const -> std::string {
+    std::string result;
+    result.reserve(total_size());
+    for_each_segment([&](string_view s) { result.append(s.data(), s.size()); });
+    return result;
+  }
+};
+
+using segmented_buffer = basic_segmented_buffer<>;
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
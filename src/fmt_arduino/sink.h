@@ -0,0 +1,155 @@
+#pragma once
+
+// Formatting into sinks: objects with a `write(const char*, size_t)` member.
+//
+// `format_to` with an output iterator stages output in an `iterator_buffer` of
+// FMT_ITERATOR_BUFFER_SIZE characters and copies it out one increment of the
+// iterator at a time. Ring buffers, sockets, SD files and `Print` (Serial,
+// WiFiClient, ...) all accept whole blocks, so `format_to(sink, ...)` stages
+// output in a buffer of `N` characters on the stack and passes each full block
+// to `sink.write` in a single call. `fmt::tee` combines several sinks into one
+// so that output sent to multiple destinations is formatted only once.
+
+#include "../fmt.h"
+
+#include <tuple>
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+template <typename Sink, typename = void> struct is_sink : std::false_type {};
+template <typename Sink>
+struct is_sink<Sink, void_t<decltype(std::declval<Sink&>().write(
+                         std::declval<const char*>(), size_t()))>>
+    : std::true_type {};
+
+// A buffer passing its contents to a sink in blocks of `N` characters.
+template <typename Sink, size_t N> class sink_buffer : public buffer<char> {
+ private:
+  Sink& sink_;
+  char data_[N];
+
+  static void grow(buffer<char>& buf, size_t) {
+    if (buf.size() == N) static_cast<sink_buffer&>(buf).flush();
+  }
+
+ public:
+  explicit sink_buffer(Sink& sink)
+      : buffer<char>(grow, data_, 0, N), sink_(sink) {}
+  sink_buffer(const sink_buffer&) = delete;
+  void operator=(const sink_buffer&) = delete;
+
+  void flush() {
+    if (size() != 0) sink_.write(data(), size());
+    clear();
+  }
+};
+
+// Calls `sink.write(data, size)` and returns the number of characters written,
+// assuming success if `write` returns nothing.
+template <typename Sink,
+          FMT_ENABLE_IF(std::is_void<decltype(std::declval<Sink&>().write(
+                            std::declval<const char*>(), size_t()))>::value)>
+auto write_to_sink(Sink& sink, const char* data, size_t size) -> size_t {
+  sink.write(data, size);
+  return size;
+}
+template <typename Sink,
+          FMT_ENABLE_IF(!std::is_void<decltype(std::declval<Sink&>().write(
+                            std::declval<const char*>(), size_t()))>::value)>
+auto write_to_sink(Sink& sink, const char* data, size_t size) -> size_t {
+  return static_cast<size_t>(sink.write(data, size));
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// The default number of characters staged before `write` is called.
+enum { default_sink_buffer_size = FMT_ITERATOR_BUFFER_SIZE };
+
+template <size_t N = default_sink_buffer_size, typename Sink,
+          FMT_ENABLE_IF(detail::is_sink<Sink>::value)>
+auto vformat_to(Sink& sink, string_view fmt, format_args args) -> Sink& {
+  static_assert(N > 0, "");
+  detail::sink_buffer<Sink, N> buf(sink);
+  detail::vformat_to(buf, fmt, args);
+  buf.flush();
+  return sink;
+}
+
+/**
+ * Formats `args` according to the format string `fmt` and writes the output
+ * to `sink` in blocks of up to `N` characters with `sink.write(data, size)`:
+ *
+ *     fmt::format_to(Serial, "T={:.1f}C\n", temp);
+ *     fmt::format_to<64>(log_file, "{} {}\n", millis(), message);
+ */
+template <size_t N = default_sink_buffer_size, typename Sink, typename... T,
+          FMT_ENABLE_IF(detail::is_sink<Sink>::value)>
+auto format_to(Sink& sink, format_string<T...> fmt, T&&... args) -> Sink& {
+  return vformat_to<N>(sink, fmt.str, vargs<T...>{{args...}});
+}
+
+/**
+ * A sink that passes each block to all `Sinks`, see `fmt::tee`. A sink that
+ * writes fewer characters than it is given, e.g. a full network buffer or a
+ * removed SD card, is marked as failed and skipped until `clear_errors` is
+ * called, so that a partial line is never followed by the rest of the output.
+ */
+template <typename... Sinks> class tee_sink {
+ private:
+  static_assert(sizeof...(Sinks) <= 32, "too many sinks");
+
+  std::tuple<Sinks&...> sinks_;
+  uint32_t failed_ = 0;
+
+  template <typename Sink>
+  void write_one(size_t index, Sink& sink, const char* data, size_t size) {
+    uint32_t bit = uint32_t(1) << index;
+    if ((failed_ & bit) == 0 && detail::write_to_sink(sink, data, size) < size)
+      failed_ |= bit;
+  }
+
+  template <size_t... Is>
+  void write_all(detail::index_sequence<Is...>, const char* data,
+                 size_t size) {
+    const int unused[] = {0, (write_one(Is, std::get<Is>(sinks_), data, size),
+                              0)...};
+    detail::ignore_unused(unused);
+  }
+
+ public:
+  explicit tee_sink(Sinks&... sinks) : sinks_(sinks...) {}
+
+  auto write(const char* data, size_t size) -> size_t {
+    write_all(detail::make_index_sequence<sizeof...(Sinks)>(), data, size);
+    return size;
+  }
+
+  /// Returns true if the sink at position `index` has failed.
+  auto failed(size_t index) const -> bool {
+    return (failed_ >> index & 1) != 0;
+  }
+
+  /// Returns true if any sink has failed.
+  auto any_failed() const -> bool { return failed_ != 0; }
+
+  /// Resumes writing to the sinks that have failed.
+  void clear_errors() { failed_ = 0; }
+};
+
+/**
+ * Returns a sink that writes to all `sinks`:
+ *
+ *     auto out = fmt::tee(Serial, log_file, udp);
+ *     fmt::format_to(out, "{} {}\n", millis(), message);
+ *     if (out.failed(1)) reopen_log_file();
+ */
+template <typename... Sinks>
+auto tee(Sinks&... sinks) -> tee_sink<Sinks...> {
+  return tee_sink<Sinks...>(sinks...);
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
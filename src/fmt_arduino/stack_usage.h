@@ -0,0 +1,65 @@
+#pragma once
+
+// Measuring the peak stack usage of formatting calls by stack painting.
+//
+// FreeRTOS tasks are often created with 2-4 KB of stack. To size them (and to
+// compare configurations such as FMT_SMALL_STACK) `fmt::measure_stack_usage`
+// fills the stack below the caller with a pattern, runs a function and
+// reports how much of the pattern has been overwritten. This works the same on
+// the host and on the board. The result is an estimate that includes the frame
+// of the function object and the call overhead of the painting helper. The
+// stack is assumed to grow downwards, which is the case on all Arduino
+// targets. Results are meaningless with AddressSanitizer, which moves locals
+// off the stack.
+
+#include "../fmt.h"
+
+// The deepest stack usage that can be measured. The probe itself needs this
+// much free stack below the caller, so keep it well under the stack size of
+// the task that runs the measurement.
+#ifndef FMT_STACK_PROBE_SIZE
+#  define FMT_STACK_PROBE_SIZE 2048
+#endif
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+enum : unsigned char { stack_paint = 0xa5 };
+
+// Paints the stack area below the caller and returns its lowest address.
+FMT_NOINLINE inline auto paint_stack() -> uintptr_t {
+  volatile unsigned char area[FMT_STACK_PROBE_SIZE];
+  for (size_t i = 0; i < sizeof(area); ++i) area[i] = stack_paint;
+  return reinterpret_cast<uintptr_t>(&area[0]);
+}
+
+// Returns the number of bytes above the lowest overwritten byte of the area
+// painted at `start`.
+inline auto scan_stack(uintptr_t start) -> size_t {
+  auto area = reinterpret_cast<const volatile unsigned char*>(start);
+  size_t untouched = 0;
+  while (untouched < FMT_STACK_PROBE_SIZE && area[untouched] == stack_paint)
+    ++untouched;
+  return FMT_STACK_PROBE_SIZE - untouched;
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/**
+ * Calls `f()` and returns an estimate of the stack it used in bytes:
+ *
+ *     size_t used = fmt::measure_stack_usage([] {
+ *       char buf[32];
+ *       fmt::format_to_n(buf, sizeof(buf), "{:.3f}", 3.14159);
+ *     });
+ */
+template <typename F> FMT_NOINLINE auto measure_stack_usage(F&& f) -> size_t {
+  auto area = detail::paint_stack();
+  f();
+  return detail::scan_stack(area);
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
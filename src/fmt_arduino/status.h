@@ -0,0 +1,220 @@
+#pragma once
+
+// Formatting functions that report errors as status codes.
+//
+// Arduino toolchains usually compile with -fno-exceptions. {fmt} then aborts
+// on an invalid runtime format string, which resets the board. The `try_`
+// functions below return a status instead and keep the output written before
+// the error. With exceptions enabled they catch the exception; without them
+// the error handler installed for the duration of the call (see
+// `fmt::set_error_handler`) jumps back to the caller with `longjmp`.
+//
+// Skipping frames with `longjmp` is undefined behavior in C++ if any of them
+// has an object with a non-trivial destructor, and formatting frames usually
+// do: `basic_memory_buffer`, the output buffers of `format_to` and objects in
+// user-defined formatters. With GCC the destructors simply don't run, so heap
+// memory they own is leaked and other cleanup is skipped, but this is not
+// guaranteed. Without exceptions use the `try_` functions only for format
+// strings that are not known at compile time and formatters that don't rely
+// on their destructors.
+
+#include "../fmt.h"
+
+#if !FMT_USE_EXCEPTIONS
+#  include <setjmp.h>
+#endif
+
+FMT_BEGIN_NAMESPACE
+
+enum class format_errc : unsigned char {
+  ok = 0,
+  /// The format string or arguments are invalid.
+  format_error,
+  /// Memory could not be allocated (only detected with exceptions).
+  out_of_memory,
+  /// A formatter threw an exception other than `format_error`.
+  other_error,
+};
+
+namespace detail {
+
+// A point to return to when a formatting error is reported. `message` and
+// `ec` are written between setjmp and longjmp, so they are volatile to keep
+// their values after longjmp returns to trap_errors.
+struct error_trap {
+  const char* volatile message = nullptr;
+  volatile format_errc ec = format_errc::ok;
+  error_handler prev_handler;
+  error_trap* prev;
+#if !FMT_USE_EXCEPTIONS
+  jmp_buf env;
+#endif
+
+  static auto current() noexcept -> error_trap*& {
+    static FMT_THREAD_LOCAL error_trap* trap = nullptr;
+    return trap;
+  }
+
+  static void on_error(const char* message) {
+    auto trap = current();
+    trap->message = message;
+    trap->ec = format_errc::format_error;
+#if !FMT_USE_EXCEPTIONS
+    longjmp(trap->env, 1);
+#endif
+  }
+};
+
+#if FMT_USE_EXCEPTIONS
+// Keeps the message of an exception that is not a format_error alive after
+// the exception object is destroyed.
+inline auto copy_error_message(const char* message) -> const char* {
+  static FMT_THREAD_LOCAL char storage[64];
+  auto n = min_of(strlen(message), sizeof(storage) - 1);
+  memcpy(storage, message, n);
+  storage[n] = '\0';
+  return storage;
+}
+#endif
+
+// Calls f() and returns the error message or null if formatting succeeds.
+// `ec` is set to the kind of the error.
+template <typename F>
+auto trap_errors(F&& f, format_errc& ec) -> const char* {
+  error_trap trap;
+  trap.prev = error_trap::current();
+  error_trap::current() = &trap;
+  trap.prev_handler = set_error_handler(error_trap::on_error);
+#if FMT_USE_EXCEPTIONS
+  FMT_TRY { f(); }
+  FMT_CATCH(const format_error& e) {
+    if (!trap.message) trap.message = copy_error_message(e.what());
+    trap.ec = format_errc::format_error;
+  }
+  FMT_CATCH(const std::bad_alloc&) {
+    trap.message = "out of memory";
+    trap.ec = format_errc::out_of_memory;
+  }
+  FMT_CATCH(const std::exception& e) {
+    trap.message = copy_error_message(e.what());
+    trap.ec = format_errc::other_error;
+  }
+#else
+#  if FMT_USE_SCRATCH_BUFFER
+  // The destructor of a scratch buffer skipped by longjmp doesn't release it.
+  bool scratch_in_use = current_scratch().in_use;
+#  endif
+  if (setjmp(trap.env) == 0) {
+    f();
+  } else {
+#  if FMT_USE_SCRATCH_BUFFER
+    current_scratch().in_use = scratch_in_use;
+#  endif
+  }
+#endif
+  set_error_handler(trap.prev_handler);
+  error_trap::current() = trap.prev;
+  ec = trap.ec;
+  return trap.message;
+}
+
+template <typename F> auto trap_errors(F&& f) -> const char* {
+  auto ec = format_errc::ok;
+  return trap_errors(f, ec);
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// The result of a `try_` formatting function.
+template <typename OutputIt> struct format_status {
+  /// Iterator past the end of the output, including partial output on error.
+  OutputIt out;
+  /// Total (not truncated) output size, or the size written before an error.
+  size_t size;
+  format_errc ec;
+  /// The error message or null on success. It is a string literal or, for
+  /// errors other than `format_error`, stays valid until the next error on
+  /// the same thread.
+  const char* message;
+
+  explicit operator bool() const noexcept { return ec == format_errc::ok; }
+};
+
+/// Formats `args` into the buffer `buf` returning an error code instead of
+/// throwing or aborting. Output written before an error is kept in `buf`.
+inline auto try_vformat_to(detail::buffer<char>& buf, string_view fmt,
+                           format_args args) -> format_status<appender> {
+  auto ec = format_errc::ok;
+  auto message =
+      detail::trap_errors([&] { detail::vformat_to(buf, fmt, args); }, ec);
+  return {appender(buf), buf.size(), ec, message};
+}
+
+template <typename OutputIt,
+          FMT_ENABLE_IF(detail::is_output_iterator<OutputIt, char>::value)>
+auto try_vformat_to_n(OutputIt out, size_t n, string_view fmt,
+                      format_args args) -> format_status<OutputIt> {
+  using traits = detail::fixed_buffer_traits;
+  auto buf = detail::iterator_buffer<OutputIt, char, traits>(out, n);
+  auto ec = format_errc::ok;
+  auto message =
+      detail::trap_errors([&] { detail::vformat_to(buf, fmt, args); }, ec);
+  auto size = buf.count();
+  return {buf.out(), size, ec, message};
+}
+
+/// Formats `args` writing the output to `out` like `vformat_to` but returns
+/// an error code instead of throwing or aborting.
+template <typename OutputIt,
+          FMT_ENABLE_IF(detail::is_output_iterator<OutputIt, char>::value)>
+auto try_vformat_to(OutputIt out, string_view fmt, format_args args)
+    -> format_status<OutputIt> {
+  return try_vformat_to_n(out, detail::max_value<size_t>(), fmt, args);
+}
+
+/**
+ * Formats `args` writing up to `n` characters to `out` like `format_to_n` but
+ * returns an error code instead of throwing or aborting:
+ *
+ *     char buf[32];
+ *     auto st = fmt::try_format_to_n(buf, sizeof(buf) - 1,
+ *                                    fmt::runtime(user_fmt), value);
+ *     *st.out = '\0';
+ *     if (!st) Serial.println(st.message);
+ */
+template <typename OutputIt, typename... T,
+          FMT_ENABLE_IF(detail::is_output_iterator<OutputIt, char>::value)>
+auto try_format_to_n(OutputIt out, size_t n, format_string<T...> fmt,
+                     T&&... args) -> format_status<OutputIt> {
+  return try_vformat_to_n(out, n, fmt.str, vargs<T...>{{args...}});
+}
+
+/**
+ * Formats `args` writing the output to `out` like `format_to` but returns an
+ * error code instead of throwing or aborting:
+ *
+ *     std::string s;
+ *     auto st = fmt::try_format_to(std::back_inserter(s),
+ *                                  fmt::runtime(user_fmt), value);
+ */
+template <typename OutputIt, typename... T,
+          FMT_ENABLE_IF(detail::is_output_iterator<remove_cvref_t<OutputIt>,
+                                                   char>::value)>
+auto try_format_to(OutputIt&& out, format_string<T...> fmt, T&&... args)
+    -> format_status<remove_cvref_t<OutputIt>> {
+  return try_vformat_to(static_cast<remove_cvref_t<OutputIt>>(out), fmt.str,
+                        vargs<T...>{{args...}});
+}
+
+/// Formats `args` into the array `out`, stopping at its end. The output is
+/// not null-terminated.
+template <size_t N, typename... T>
+auto try_format_to(char (&out)[N], format_string<T...> fmt, T&&... args)
+    -> format_status<char*> {
+  return try_vformat_to_n(out, N, fmt.str, vargs<T...>{{args...}});
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
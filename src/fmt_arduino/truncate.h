@@ -0,0 +1,157 @@
+#pragma once
+
+// Formatting into fixed-size character arrays that stops once they are full.
+//
+// `format_to_n` keeps formatting after its output is full to compute the size
+// of the complete output. `format_truncated` is for callers that only need
+// what fits, such as display lines and fixed-size radio frames: it skips the
+// remaining replacement fields once the array is full, always null-terminates
+// and optionally ends truncated output with a marker such as "...".
+
+#include "../fmt.h"
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+// A buffer writing to an array that discards everything past its end.
+class truncating_buffer : public buffer<char> {
+ private:
+  char* out_;
+  size_t size_ = 0;  // The number of characters kept in out_.
+  bool full_ = false;
+  char discard_[32];
+
+  static void grow(buffer<char>& buf, size_t) {
+    auto& self = static_cast<truncating_buffer&>(buf);
+    if (buf.size() != buf.capacity()) return;
+    if (buf.data() == self.out_) self.size_ = buf.size();
+    self.full_ = true;
+    self.set(self.discard_, sizeof(self.discard_));
+    self.clear();
+  }
+
+ public:
+  truncating_buffer(char* out, size_t n)
+      : buffer<char>(grow, out, 0, n), out_(out) {}
+
+  /// Returns true if some output has been discarded.
+  auto full() const -> bool { return full_; }
+
+  /// Returns the number of characters written to the array.
+  auto count() const -> size_t { return full_ ? size_ : this->size(); }
+};
+
+// A format handler that stops formatting once the output is full.
+template <typename Char>
+struct truncating_format_handler : format_handler<Char> {
+  const truncating_buffer& buf;
+
+  truncating_format_handler(basic_string_view<Char> fmt,
+                            buffered_context<Char> ctx,
+                            const truncating_buffer& b)
+      : format_handler<Char>{parse_context<Char>(fmt),
+                             static_cast<buffered_context<Char>&&>(ctx)},
+        buf(b) {}
+
+  void on_text(const Char* begin, const Char* end) {
+    if (!buf.full()) format_handler<Char>::on_text(begin, end);
+  }
+
+  void on_replacement_field(int id, const Char* begin) {
+    if (!buf.full()) format_handler<Char>::on_replacement_field(id, begin);
+  }
+
+  auto on_format_specs(int id, const Char* begin, const Char* end)
+      -> const Char* {
+    if (!buf.full())
+      return format_handler<Char>::on_format_specs(id, begin, end);
+    // Skip the specs including nested replacement fields.
+    for (int depth = 0; begin != end && (depth > 0 || *begin != '}');
+         ++begin) {
+      if (*begin == '{')
+        ++depth;
+      else if (*begin == '}')
+        --depth;
+    }
+    return begin;
+  }
+};
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/// A marker that ends truncated output, e.g. `fmt::ellipsis("...")`.
+struct ellipsis {
+  string_view marker;
+  constexpr explicit ellipsis(string_view m) : marker(m) {}
+};
+
+struct truncated_result {
+  /// Pointer to the terminating null character.
+  char* out;
+  /// The number of characters written excluding the terminating null.
+  size_t size;
+  /// Specifies if the output was truncated.
+  bool truncated;
+};
+
+/**
+ * Formats `args` into the array of `n` characters at `out`. Formatting stops
+ * once the array is full; output that does not fit is dropped and `marker`,
+ * if not empty, replaces its last characters. The output is always
+ * null-terminated. Errors in the part of the format string that is skipped
+ * are not reported.
+ */
+inline auto vformat_truncated(char* out, size_t n, string_view fmt,
+                              format_args args, string_view marker = {})
+    -> truncated_result {
+  if (n == 0) return {out, 0, true};
+  auto buf = detail::truncating_buffer(out, n - 1);
+  detail::parse_format_string(
+      fmt, detail::truncating_format_handler<char>(
+               fmt, context(appender(buf), args), buf));
+  size_t size = buf.count();
+  if (buf.full() && marker.size() != 0) {
+    size_t pos = marker.size() < n - 1 ? n - 1 - marker.size() : 0;
+    // Don't cut a UTF-8 sequence.
+    while (pos > 0 && (static_cast<unsigned char>(out[pos]) & 0xc0) == 0x80)
+      --pos;
+    size = pos + min_of(marker.size(), n - 1 - pos);
+    memcpy(out + pos, marker.data(), size - pos);
+  }
+  out[size] = '\0';
+  return {out + size, size, buf.full()};
+}
+
+/**
+ * Formats `args` into `out` like `format_to` but stops at the end of the
+ * array and null-terminates the output.
+ *
+ * **Example**:
+ *
+ *     char line[17];
+ *     auto result = fmt::format_truncated(line, fmt::ellipsis("..."),
+ *                                         "{}: {:.1f}C", name, temp);
+ */
+template <size_t N, typename... T>
+auto format_truncated(char (&out)[N], format_string<T...> fmt, T&&... args)
+    -> truncated_result {
+  return vformat_truncated(out, N, fmt.str, vargs<T...>{{args...}});
+}
+
+template <size_t N, typename... T>
+auto format_truncated(char (&out)[N], ellipsis e, format_string<T...> fmt,
+                      T&&... args) -> truncated_result {
+  return vformat_truncated(out, N, fmt.str, vargs<T...>{{args...}},
+                           e.marker);
+}
+
+template <typename... T>
+auto format_truncated(char* out, size_t n, format_string<T...> fmt,
+                      T&&... args) -> truncated_result {
+  return vformat_truncated(out, n, fmt.str, vargs<T...>{{args...}});
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
@@ -1,9 +1,33 @@
 // More information about PlatformIO Unit Testing:
 // https://docs.platformio.org/en/latest/advanced/unit-testing/index.html
 
+// Enable the optional features that are tested below
+#define FMT_USE_SCRATCH_BUFFER 1
+#define FMT_ALLOC_STATS 1
+#define FMT_USE_PROGMEM 1
+
 #include <Arduino.h>
+#include <map>
 #include "unity.h"
 #include "fmt.h"
+#include "fmt_arduino/arena_args.h"
+#include "fmt_arduino/checksum.h"
+#include "fmt_arduino/compress.h"
+#include "fmt_arduino/csv.h"
+#include "fmt_arduino/encoding.h"
+#include "fmt_arduino/flash.h"
+#include "fmt_arduino/framing.h"
+#include "fmt_arduino/from_chars.h"
+#include "fmt_arduino/hash.h"
+#include "fmt_arduino/json.h"
+#include "fmt_arduino/logfmt.h"
+#include "fmt_arduino/named_format.h"
+#include "fmt_arduino/scan.h"
+#include "fmt_arduino/segmented_buffer.h"
+#include "fmt_arduino/sink.h"
+#include "fmt_arduino/stack_usage.h"
+#include "fmt_arduino/status.h"
+#include "fmt_arduino/truncate.h"
 
 /*------------------------------------------------------------------------------
  * TESTS FOR format (std::string)
@@ -430,6 +454,111 @@ void test_arduino_string_formatter()
 	char buffer[25] = {0}; // Increased buffer size to prevent overflow
 	fmt::format_to(buffer, "Greeting: {:>10}", shortStr);
 	TEST_ASSERT_EQUAL_STRING_MESSAGE("Greeting:         Hi", buffer, "Arduino String with alignment");
+
+	// Precision and fill work on the stored length
+	String longStr = "Arduino String";
+	result = fmt::format("[{:.7}] [{:*<16}]", longStr, longStr);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("[Arduino] [Arduino String**]", result.c_str(), "Arduino String precision and fill");
+}
+
+// A string with the functions used by fmt::format_to(String&) that counts
+// the calls to reserve
+struct counting_string
+{
+	std::string value;
+	unsigned int capacity = 0;
+	int reserves = 0;
+
+	unsigned int length() const { return static_cast<unsigned int>(value.size()); }
+
+	unsigned char reserve(unsigned int n)
+	{
+		if (n > capacity)
+		{
+			capacity = n;
+			++reserves;
+		}
+		return 1;
+	}
+
+	bool concat(const char *s, unsigned int n)
+	{
+		value.append(s, n);
+		return true;
+	}
+};
+
+void test_format_to_arduino_string()
+{
+	String message = "T=";
+	fmt::format_to(message, "{:.1f}C", 21.55);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("T=21.6C", message.c_str(), "format_to String appends");
+
+	// Output longer than the staging area is appended in chunks
+	String long_message;
+	fmt::format_to(long_message, "{:-^150}|{}", "mid", 7);
+	TEST_ASSERT_EQUAL_MESSAGE(152, long_message.length(), "format_to String long output length");
+	TEST_ASSERT_EQUAL_MESSAGE('m', long_message[73], "format_to String long output content");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("-|7", long_message.c_str() + 149, "format_to String long output end");
+
+	String result = fmt::format_arduino("{}:{}", "id", 42);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("id:42", result.c_str(), "format_arduino");
+
+	// Long output reserves capacity geometrically
+	counting_string counted;
+	{
+		fmt::detail::string_buffer<counting_string> buf(counted);
+		for (int i = 0; i < 400; ++i)
+			fmt::format_to(fmt::appender(buf), "{:09}\n", i);
+	}
+	TEST_ASSERT_EQUAL_MESSAGE(4000, counted.value.size(), "format_to String counted length");
+	TEST_ASSERT_TRUE_MESSAGE(counted.reserves <= 12, "format_to String reserves geometrically");
+	counting_string short_output;
+	{
+		fmt::detail::string_buffer<counting_string> buf(short_output);
+		fmt::format_to(fmt::appender(buf), "{}", 42);
+	}
+	TEST_ASSERT_EQUAL_MESSAGE(1, short_output.reserves, "format_to String reserves short output once");
+	TEST_ASSERT_EQUAL_MESSAGE(2, short_output.capacity, "format_to String reserves the exact size");
+}
+
+struct ip_address : Printable
+{
+	uint8_t octets[4];
+
+	size_t printTo(Print &p) const override
+	{
+		size_t n = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			if (i > 0)
+				n += p.print('.');
+			n += p.print(static_cast<unsigned>(octets[i]));
+		}
+		return n;
+	}
+};
+
+void test_printable_formatter()
+{
+	ip_address ip;
+	ip.octets[0] = 192;
+	ip.octets[1] = 168;
+	ip.octets[2] = 1;
+	ip.octets[3] = 20;
+	std::string result = fmt::format("IP: {}", ip);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("IP: 192.168.1.20", result.c_str(), "Printable formatter");
+
+	result = fmt::format("[{:>14}] [{:*<14}] [{:^{}}]", ip, ip, ip, 16);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("[  192.168.1.20] [192.168.1.20**] [  192.168.1.20  ]", result.c_str(), "Printable formatter alignment");
+
+	result = fmt::format("[{:.7}] [{:>9.3}]", ip, ip);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("[192.168] [      192]", result.c_str(), "Printable formatter precision");
+
+	char buffer[20];
+	auto end = fmt::format_to(buffer, "{}", ip);
+	*end = '\0';
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("192.168.1.20", buffer, "Printable formatter format_to");
 }
 
 /*------------------------------------------------------------------------------
@@ -497,6 +626,1304 @@ void test_timestamp_formatting()
 	TEST_ASSERT_EQUAL_STRING_MESSAGE("Uptime: 1234.567s", result.c_str(), "timestamp formatting");
 }
 
+/*------------------------------------------------------------------------------
+ * TESTS FOR named_format
+ *----------------------------------------------------------------------------*/
+
+void test_named_arguments()
+{
+	std::string result = fmt::format("{name}: {value:.1f}", fmt::arg("name", "temp"), fmt::arg("value", 21.56));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("temp: 21.6", result.c_str(), "named arguments");
+}
+
+void test_named_format_basic()
+{
+	static const fmt::named_format payload("{{\"t\":{temp:.1f},\"h\":{hum}}}", {"temp", "hum"});
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("{{\"t\":{0:.1f},\"h\":{1}}}", std::string(payload.str().data(), payload.str().size()).c_str(),
+									 "named_format rewritten string");
+
+	std::string result = fmt::format(payload, fmt::arg("temp", 23.44), fmt::arg("hum", 67));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("{\"t\":23.4,\"h\":67}", result.c_str(), "named_format with named args");
+
+	// Positional arguments work as well since names are resolved to positions
+	result = fmt::format(payload, 1.25, 50);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("{\"t\":1.2,\"h\":50}", result.c_str(), "named_format with positional args");
+
+	// Arguments are matched by position, so named arguments out of order are an error
+	const char *message = fmt::detail::trap_errors([] { (void)fmt::format(payload, fmt::arg("hum", 67), fmt::arg("temp", 23.44)); });
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("named argument passed out of order", message, "named_format argument order");
+}
+
+void test_named_format_mixed_and_dynamic_specs()
+{
+	static const fmt::named_format line("{0} {name:>{width}} {3}", {"", "name", "width", ""});
+	std::string result = fmt::format(line, "id", fmt::arg("name", "abc"), fmt::arg("width", 5), "end");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("id   abc end", result.c_str(), "named_format mixed with positional ids");
+
+	char buffer[16] = {0};
+	fmt::format_to(buffer, line, 1, fmt::arg("name", "x"), fmt::arg("width", 2), 3);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("1  x 3", buffer, "named_format format_to");
+
+	// Automatic ids can't be mixed with manual or named ids, as with fmt::format
+	static const fmt::named_format autos("{} {}", {"v"});
+	result = fmt::format(autos, fmt::arg("v", 7), 8);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("7 8", result.c_str(), "named_format with automatic ids");
+	const char *message = fmt::detail::trap_errors([] { fmt::named_format mixed("{} {v} {}", {"v"}); });
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("cannot switch from manual to automatic argument indexing", message,
+									 "named_format automatic after named id");
+	message = fmt::detail::trap_errors([] { fmt::named_format mixed("{} {0} {}", {""}); });
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("cannot switch from automatic to manual argument indexing", message,
+									 "named_format manual after automatic id");
+}
+
+void test_named_format_many_names()
+{
+	// Larger than the inline hash table to exercise growth
+	std::string fmt_str, expected;
+	for (int i = 0; i < 40; i++)
+	{
+		fmt_str += "{n" + std::to_string(39 - i) + "}";
+		expected += std::to_string(39 - i);
+	}
+	fmt::named_format many(fmt::string_view(fmt_str.data(), fmt_str.size()),
+						   {"n0", "n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8", "n9",
+							"n10", "n11", "n12", "n13", "n14", "n15", "n16", "n17", "n18", "n19",
+							"n20", "n21", "n22", "n23", "n24", "n25", "n26", "n27", "n28", "n29",
+							"n30", "n31", "n32", "n33", "n34", "n35", "n36", "n37", "n38", "n39"});
+	std::string result = fmt::format(many, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+									 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.c_str(), result.c_str(), "named_format with many names");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR arena_format_arg_store
+ *----------------------------------------------------------------------------*/
+
+void test_arena_args_basic()
+{
+	fmt::arena_format_arg_store<fmt::format_context> store;
+	char name[] = "sensor";
+	store.push_back(42);
+	store.push_back(name);
+	store.push_back(std::string("abc"));
+	store.push_back(2.5);
+	name[0] = 'S'; // The store holds a copy
+	std::string result = fmt::vformat("{} {} {} {}", store);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("42 sensor abc 2.5", result.c_str(), "arena store positional");
+	TEST_ASSERT_EQUAL_MESSAGE(4, store.size(), "arena store size");
+}
+
+void test_arena_args_named_and_custom()
+{
+	fmt::arena_format_arg_store<fmt::format_context> store;
+	store.push_back(fmt::arg("topic", std::string("home/temp")));
+	store.push_back(String("arduino"));
+	store.push_back(fmt::arg("value", 21.5));
+	std::string result = fmt::vformat("{topic}={value} {1}", store);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("home/temp=21.5 arduino", result.c_str(), "arena store named");
+}
+
+void test_arena_args_reuse()
+{
+	fmt::arena_format_arg_store<fmt::format_context, 16> store;
+	std::string big(100, 'x');
+	for (int i = 0; i < 3; i++)
+	{
+		store.clear();
+		store.push_back(fmt::arg("a", big));
+		store.push_back(fmt::arg("b", big));
+		store.push_back(i);
+		std::string result = fmt::vformat("{2}", store);
+		TEST_ASSERT_EQUAL_STRING_MESSAGE(fmt::format("{}", i).c_str(), result.c_str(), "arena store reuse");
+	}
+	// After the first message the chained blocks were merged into one block
+	size_t capacity = store.arena_capacity();
+	TEST_ASSERT_TRUE_MESSAGE(capacity >= 2 * 101, "arena store merged capacity");
+	store.clear();
+	store.push_back(fmt::arg("a", big));
+	store.push_back(fmt::arg("b", big));
+	store.clear();
+	TEST_ASSERT_EQUAL_MESSAGE(capacity, store.arena_capacity(), "arena store steady state");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR try_ formatting functions
+ *----------------------------------------------------------------------------*/
+
+void test_try_format_to_n_ok()
+{
+	char buffer[16] = {0};
+	auto status = fmt::try_format_to_n(buffer, sizeof(buffer) - 1, "Value: {}", 42);
+	*status.out = '\0';
+	TEST_ASSERT_TRUE_MESSAGE(static_cast<bool>(status), "try_format_to_n success");
+	TEST_ASSERT_EQUAL_MESSAGE(9, status.size, "try_format_to_n size");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("Value: 42", buffer, "try_format_to_n output");
+}
+
+void test_try_format_to_n_error()
+{
+	// Missing argument: partial output before the error is kept
+	char buffer[32] = {0};
+	auto status = fmt::try_format_to_n(buffer, sizeof(buffer) - 1, fmt::runtime("a={} b={}"), 1);
+	*status.out = '\0';
+	TEST_ASSERT_FALSE_MESSAGE(static_cast<bool>(status), "try_format_to_n error");
+	TEST_ASSERT_TRUE_MESSAGE(status.ec == fmt::format_errc::format_error, "try_format_to_n error code");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("argument not found", status.message, "try_format_to_n error message");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("a=1 b=", buffer, "try_format_to_n partial output");
+
+	// Invalid specifier
+	char small[8];
+	auto spec_status = fmt::try_format_to(small, fmt::runtime("{:q}"), 1);
+	TEST_ASSERT_FALSE_MESSAGE(static_cast<bool>(spec_status), "try_format_to invalid specifier");
+
+	// Formatting keeps working after an error
+	auto ok = fmt::try_format_to(small, "{}", 7);
+	TEST_ASSERT_TRUE_MESSAGE(static_cast<bool>(ok), "try_format_to after error");
+	TEST_ASSERT_EQUAL_MESSAGE('7', small[0], "try_format_to after error output");
+}
+
+#if FMT_USE_EXCEPTIONS
+// A value whose formatter throws an exception other than format_error
+struct throwing_value
+{
+	bool out_of_memory;
+};
+
+template <>
+struct fmt::formatter<throwing_value> : fmt::formatter<int>
+{
+	auto format(const throwing_value &value, fmt::format_context &) const -> fmt::format_context::iterator
+	{
+		if (value.out_of_memory)
+			throw std::bad_alloc();
+		throw std::runtime_error("sensor offline");
+	}
+};
+#endif
+
+void test_try_vformat_to_buffer()
+{
+	fmt::memory_buffer buffer;
+	auto status = fmt::try_vformat_to(buffer, "{} {:d}", fmt::make_format_args("x", "y"));
+	TEST_ASSERT_FALSE_MESSAGE(static_cast<bool>(status), "try_vformat_to error");
+	TEST_ASSERT_EQUAL_MESSAGE(2, buffer.size(), "try_vformat_to partial size");
+
+	std::string output;
+	auto it_status = fmt::try_format_to(std::back_inserter(output), "{}-{}", 12, "ab");
+	TEST_ASSERT_TRUE_MESSAGE(static_cast<bool>(it_status), "try_format_to output iterator");
+	TEST_ASSERT_EQUAL_MESSAGE(5, it_status.size, "try_format_to output iterator size");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("12-ab", output.c_str(), "try_format_to output iterator output");
+	it_status = fmt::try_format_to(std::back_inserter(output), fmt::runtime("{}{}"), 3);
+	TEST_ASSERT_TRUE_MESSAGE(it_status.ec == fmt::format_errc::format_error && output == "12-ab3", "try_format_to output iterator error");
+
+#if FMT_USE_EXCEPTIONS
+	char small[8];
+	auto alloc_status = fmt::try_format_to(small, "{}", throwing_value{true});
+	TEST_ASSERT_TRUE_MESSAGE(alloc_status.ec == fmt::format_errc::out_of_memory, "try_format_to out of memory");
+	auto other_status = fmt::try_format_to(small, "{}", throwing_value{false});
+	TEST_ASSERT_TRUE_MESSAGE(other_status.ec == fmt::format_errc::other_error, "try_format_to other exception");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("sensor offline", other_status.message, "try_format_to other exception message");
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR format_truncated
+ *----------------------------------------------------------------------------*/
+
+struct counted
+{
+	int value;
+};
+
+static int counted_formats = 0;
+
+template <>
+struct fmt::formatter<counted> : fmt::formatter<int>
+{
+	auto format(const counted &c, fmt::format_context &ctx) const -> decltype(ctx.out())
+	{
+		counted_formats++;
+		return fmt::formatter<int>::format(c.value, ctx);
+	}
+};
+
+void test_format_truncated_fits()
+{
+	char buffer[16];
+	auto result = fmt::format_truncated(buffer, "Temp: {}", 21);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("Temp: 21", buffer, "format_truncated fits");
+	TEST_ASSERT_EQUAL_MESSAGE(8, result.size, "format_truncated size");
+	TEST_ASSERT_FALSE_MESSAGE(result.truncated, "format_truncated not truncated");
+	TEST_ASSERT_TRUE_MESSAGE(result.out == buffer + 8, "format_truncated out");
+
+	// Exactly filling the array leaves room for the terminator
+	char exact[4];
+	result = fmt::format_truncated(exact, "{}", 123);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("123", exact, "format_truncated exact fit");
+	TEST_ASSERT_FALSE_MESSAGE(result.truncated, "format_truncated exact fit not truncated");
+}
+
+void test_format_truncated_stops_early()
+{
+	char buffer[8];
+	counted_formats = 0;
+	auto result = fmt::format_truncated(buffer, "{} {} {} {:>4} {}", counted{1234}, counted{5678},
+										counted{9}, counted{10}, counted{11});
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("1234 56", buffer, "format_truncated truncated output");
+	TEST_ASSERT_TRUE_MESSAGE(result.truncated, "format_truncated truncated");
+	TEST_ASSERT_EQUAL_MESSAGE(7, result.size, "format_truncated truncated size");
+	TEST_ASSERT_EQUAL_MESSAGE(2, counted_formats, "format_truncated skips formatters after full");
+}
+
+void test_format_truncated_ellipsis()
+{
+	char line[11];
+	auto result = fmt::format_truncated(line, fmt::ellipsis("..."), "Status: {}", "connected");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("Status:...", line, "format_truncated ellipsis");
+	TEST_ASSERT_TRUE_MESSAGE(result.truncated, "format_truncated ellipsis truncated");
+
+	result = fmt::format_truncated(line, fmt::ellipsis("..."), "OK");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("OK", line, "format_truncated ellipsis not needed");
+
+	// Multi-byte characters are not cut in half
+	result = fmt::format_truncated(line, fmt::ellipsis("~"), "{}", "aaaaaaaa\xc3\xa9" "b");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("aaaaaaaa~", line, "format_truncated ellipsis utf-8");
+
+	char *tiny = line;
+	result = fmt::format_truncated(tiny, 1, "abc");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("", tiny, "format_truncated terminator only");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR the format scratch buffer
+ *----------------------------------------------------------------------------*/
+
+struct nested_format
+{
+	int value;
+};
+
+template <>
+struct fmt::formatter<nested_format> : fmt::formatter<std::string>
+{
+	auto format(const nested_format &n, fmt::format_context &ctx) const -> decltype(ctx.out())
+	{
+		return fmt::formatter<std::string>::format(fmt::format("<{}>", n.value), ctx);
+	}
+};
+
+void test_scratch_buffer_reuse()
+{
+	fmt::release_scratch_buffer();
+	std::string first = fmt::format("{:>600}", "end");
+	TEST_ASSERT_EQUAL_MESSAGE(600, first.size(), "scratch buffer long output");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("end", first.c_str() + 597, "scratch buffer long output content");
+
+	auto stats = fmt::get_scratch_buffer_stats();
+	TEST_ASSERT_TRUE_MESSAGE(stats.capacity >= 600, "scratch buffer capacity retained");
+	TEST_ASSERT_EQUAL_MESSAGE(600, stats.peak_size, "scratch buffer peak size");
+	TEST_ASSERT_EQUAL_MESSAGE(0, stats.reuse_count, "scratch buffer first call grows");
+
+	std::string second = fmt::format("Value: {}", 42);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("Value: 42", second.c_str(), "scratch buffer reused output");
+	auto after = fmt::get_scratch_buffer_stats();
+	TEST_ASSERT_EQUAL_MESSAGE(stats.capacity, after.capacity, "scratch buffer capacity unchanged");
+	TEST_ASSERT_EQUAL_MESSAGE(1, after.reuse_count, "scratch buffer reuse count");
+
+	fmt::release_scratch_buffer();
+	TEST_ASSERT_EQUAL_MESSAGE(0, fmt::get_scratch_buffer_stats().capacity, "scratch buffer released");
+}
+
+void test_scratch_buffer_nested()
+{
+	std::string result = fmt::format("{} and {}", nested_format{1}, nested_format{2});
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("<1> and <2>", result.c_str(), "scratch buffer nested format");
+
+	// An error trapped inside fmt::format doesn't leave the buffer marked in use
+	fmt::detail::trap_errors([] { (void)fmt::format(fmt::runtime("{} {}"), 1); });
+	auto before = fmt::get_scratch_buffer_stats();
+	result = fmt::format("{}", 42);
+	TEST_ASSERT_EQUAL_MESSAGE(before.reuse_count + 1, fmt::get_scratch_buffer_stats().reuse_count, "scratch buffer usable after an error");
+	fmt::release_scratch_buffer();
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR flash format strings and arguments
+ *----------------------------------------------------------------------------*/
+
+void test_flash_format_string()
+{
+	std::string result = fmt::format(F("T={:.1f}C {{ok}} {:>4}"), 21.55, 7);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("T=21.6C {ok}    7", result.c_str(), "flash format string");
+
+	result = fmt::format(F("{1}-{0}-{1}"), "a", "b");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("b-a-b", result.c_str(), "flash format string positional");
+
+	result = fmt::format(F("[{:*^{}}] [{name}]"), "x", 5, fmt::arg("name", 3));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("[**x**] [3]", result.c_str(), "flash format string dynamic width and names");
+
+	char buffer[16];
+	auto end = fmt::format_to(buffer, F("id={:04}"), 42);
+	*end = '\0';
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("id=0042", buffer, "flash format_to array");
+
+	auto n_result = fmt::format_to_n(buffer, 4, F("{}{}"), 123, 456);
+	TEST_ASSERT_EQUAL_MESSAGE(6, n_result.size, "flash format_to_n size");
+	TEST_ASSERT_EQUAL_MEMORY_MESSAGE("1234", buffer, 4, "flash format_to_n output");
+
+	String message = "> ";
+	fmt::format_to(message, F("{} {}"), "ok", 1);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("> ok 1", message.c_str(), "flash format_to String");
+}
+
+void test_flash_format_errors()
+{
+	const char *message = fmt::detail::trap_errors([] { (void)fmt::format(F("{} {1}"), 1, 2); });
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("cannot switch from automatic to manual argument indexing", message,
+									 "flash format string indexing error");
+
+	message = fmt::detail::trap_errors([] { (void)fmt::format(F("{} {}"), 1); });
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("argument not found", message, "flash format string missing argument");
+
+	message = fmt::detail::trap_errors([] { (void)fmt::format(F("{:>"), 1); });
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("invalid format string", message, "flash format string unterminated field");
+}
+
+void test_flash_string_argument()
+{
+	std::string result = fmt::format("{}: {:>6}|{:.3}|{:-<5}", fmt::flash(F("state")), fmt::flash(F("on")),
+									 fmt::flash(F("abcdef")), fmt::flash(F("x")));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("state:     on|abc|x----", result.c_str(), "flash string argument");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR output of table-driven code paths
+ *----------------------------------------------------------------------------*/
+
+// These cover the digit, Dragonbox and is_printable tables that are placed in
+// program memory when FMT_USE_PROGMEM is enabled; the output must not change.
+void test_table_lookup_output()
+{
+	std::string result = fmt::format("{} {} {} {} {}", 7u, 42u, 4294967295u, 18446744073709551615ull, -1234567890123ll);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("7 42 4294967295 18446744073709551615 -1234567890123", result.c_str(), "integer digit tables");
+
+	result = fmt::format("{} {} {} {}", 0.1f, 3.4028235e38f, 1e-45f, 123.456f);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("0.1 3.4028235e+38 1e-45 123.456", result.c_str(), "float cache table");
+
+	result = fmt::format("{} {} {} {} {}", 0.1, 1.7976931348623157e308, 5e-324, 2.2250738585072014e-308, 1e23);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("0.1 1.7976931348623157e+308 5e-324 2.2250738585072014e-308 1e+23", result.c_str(),
+									 "double cache tables");
+
+	result = fmt::format("{:e} {:.3e} {:.1f}", 6.02214076e23, 1.5e-100, 1234.56);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("6.022141e+23 1.500e-100 1234.6", result.c_str(), "exponent digits");
+
+	result = fmt::format("{:?}", "a\xc3\xa9\xcd\xb8\xf0\x9f\x98\x80");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("\"a\xc3\xa9\\u0378\xf0\x9f\x98\x80\"", result.c_str(), "is_printable tables");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR stack usage measurement
+ *----------------------------------------------------------------------------*/
+
+void test_measure_stack_usage()
+{
+	size_t known = fmt::measure_stack_usage([]
+											{
+		volatile char block[1024];
+		for (size_t i = 0; i < sizeof(block); i++)
+			block[i] = 0; });
+#ifndef __SANITIZE_ADDRESS__ // AddressSanitizer moves locals off the stack
+	TEST_ASSERT_TRUE_MESSAGE(known >= 1024, "measure_stack_usage covers a known frame");
+	TEST_ASSERT_TRUE_MESSAGE(known < 1024 + 512, "measure_stack_usage is close to a known frame");
+#else
+	(void)known;
+#endif
+
+	static char buffer[32];
+	size_t used = fmt::measure_stack_usage([]
+										   { fmt::format_to_n(buffer, sizeof(buffer), "{} {:.3f}", 42, 3.14159); });
+	TEST_ASSERT_TRUE_MESSAGE(used > 64, "measure_stack_usage format_to_n");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR allocation statistics and budgets
+ *----------------------------------------------------------------------------*/
+
+void test_alloc_stats()
+{
+	fmt::release_scratch_buffer();
+	{
+		fmt::alloc_scope scope;
+		std::string result = fmt::format("{:>300}", "x");
+		auto stats = scope.stats();
+		TEST_ASSERT_EQUAL_MESSAGE(1, stats.allocations, "alloc_scope format allocations");
+		TEST_ASSERT_EQUAL_MESSAGE(300, stats.bytes, "alloc_scope format bytes");
+		TEST_ASSERT_EQUAL_MESSAGE(300, stats.bytes_in_use, "alloc_scope scratch memory retained");
+
+		// The retained buffer is reused without allocating
+		result = fmt::format("{:>200}", "y");
+		TEST_ASSERT_EQUAL_MESSAGE(1, scope.stats().allocations, "alloc_scope reused scratch buffer");
+	}
+	{
+		fmt::alloc_scope scope;
+		{
+			fmt::memory_buffer buffer;
+			fmt::format_to(fmt::appender(buffer), "{:>600}", "x");
+		}
+		auto stats = scope.stats();
+		TEST_ASSERT_EQUAL_MESSAGE(1, stats.allocations, "alloc_scope memory_buffer allocations");
+		TEST_ASSERT_EQUAL_MESSAGE(0, stats.bytes_in_use, "alloc_scope memory_buffer freed");
+		TEST_ASSERT_TRUE_MESSAGE(stats.peak_bytes >= 600, "alloc_scope memory_buffer peak");
+	}
+
+	// Memory allocated elsewhere, e.g. on another thread, doesn't wrap the count
+	auto in_use = fmt::get_alloc_stats().bytes_in_use;
+	fmt::detail::allocator<char>().deallocate(static_cast<char *>(malloc(in_use + 16)), in_use + 16);
+	TEST_ASSERT_EQUAL_MESSAGE(0, fmt::get_alloc_stats().bytes_in_use, "alloc stats saturate at 0");
+	fmt::release_scratch_buffer();
+}
+
+void test_alloc_budget()
+{
+	// The retained scratch buffer is larger than the budget
+	std::string result = fmt::format("{:>300}", "x");
+	{
+		fmt::alloc_scope scope(16);
+		result = fmt::format("{}-{}", "0123456789", "abcdefghij");
+		TEST_ASSERT_EQUAL_STRING_MESSAGE("0123456789-abcde", result.c_str(), "alloc budget truncates");
+		TEST_ASSERT_EQUAL_MESSAGE(1, scope.stats().truncations, "alloc budget truncation count");
+	}
+	fmt::release_scratch_buffer();
+	{
+		fmt::alloc_scope scope(16);
+		result = fmt::format("{:>40}", 1);
+		TEST_ASSERT_EQUAL_MESSAGE(16, result.size(), "alloc budget limits growth");
+		TEST_ASSERT_TRUE_MESSAGE(scope.stats().bytes <= 16, "alloc budget bytes");
+	}
+	result = fmt::format("{}-{}", "0123456789", "abcdefghij");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("0123456789-abcdefghij", result.c_str(), "alloc budget restored");
+	fmt::release_scratch_buffer();
+}
+
+void test_alloc_budget_memory_buffer()
+{
+	fmt::basic_memory_buffer<char, 16> buffer;
+	buffer.append(fmt::string_view("id="));
+	{
+		fmt::alloc_scope scope(100);
+		fmt::format_to(fmt::appender(buffer), "{:>1000}", "x");
+		TEST_ASSERT_EQUAL_MESSAGE(103, buffer.size(), "alloc budget limits format_to");
+		TEST_ASSERT_TRUE_MESSAGE(buffer.capacity() < 1000, "alloc budget limits memory_buffer growth");
+		TEST_ASSERT_EQUAL_MESSAGE(1, scope.stats().truncations, "alloc budget format_to truncation count");
+
+		// Each call has its own budget
+		buffer.clear();
+		fmt::format_to(std::back_inserter(buffer), "{}{}", 1, 2);
+		fmt::format_to(fmt::appender(buffer), "{:>99}", 3);
+		TEST_ASSERT_EQUAL_MESSAGE(101, buffer.size(), "alloc budget per call");
+		TEST_ASSERT_EQUAL_MESSAGE(1, scope.stats().truncations, "alloc budget no truncation within budget");
+	}
+	buffer.clear();
+	fmt::format_to(fmt::appender(buffer), "{:>1000}", "x");
+	TEST_ASSERT_EQUAL_MESSAGE(1000, buffer.size(), "alloc budget restored for format_to");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR segmented_buffer
+ *----------------------------------------------------------------------------*/
+
+// A Print that appends the written bytes to a string
+struct string_print : Print
+{
+	std::string output;
+	size_t writes = 0;
+
+	using Print::write;
+
+	size_t write(uint8_t c) override
+	{
+		output += static_cast<char>(c);
+		++writes;
+		return 1;
+	}
+
+	size_t write(const uint8_t *buffer, size_t size) override
+	{
+		output.append(reinterpret_cast<const char *>(buffer), size);
+		++writes;
+		return size;
+	}
+};
+
+void test_segmented_buffer()
+{
+	static_assert(!std::is_convertible<fmt::segmented_buffer &, fmt::detail::buffer<char> &>::value,
+				  "segmented_buffer is not usable as a single buffer");
+	fmt::basic_segmented_buffer<16> buffer;
+	fmt::format_to(buffer.out(), "{}|{:>20}|{}", "0123456789", 42, 3.5);
+	std::string expected = fmt::format("{}|{:>20}|{}", "0123456789", 42, 3.5);
+	TEST_ASSERT_EQUAL_MESSAGE(expected.size(), buffer.total_size(), "segmented_buffer total_size");
+	TEST_ASSERT_EQUAL_MESSAGE(3, buffer.num_segments(), "segmented_buffer segments");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.c_str(), buffer.str().c_str(), "segmented_buffer contents");
+
+	size_t largest = 0;
+	buffer.for_each_segment([&](fmt::string_view s) { largest = s.size() > largest ? s.size() : largest; });
+	TEST_ASSERT_EQUAL_MESSAGE(16, largest, "segmented_buffer segment size");
+
+	string_print print;
+	TEST_ASSERT_EQUAL_MESSAGE(expected.size(), buffer.write_to(print), "segmented_buffer write_to size");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.c_str(), print.output.c_str(), "segmented_buffer write_to");
+	TEST_ASSERT_EQUAL_MESSAGE(3, print.writes, "segmented_buffer one write per segment");
+
+	buffer.reset();
+	TEST_ASSERT_EQUAL_MESSAGE(0, buffer.total_size(), "segmented_buffer reset");
+	fmt::format_to(buffer.out(), "{}", 7);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("7", buffer.str().c_str(), "segmented_buffer after reset");
+}
+
+void test_segment_pool()
+{
+	fmt::segment_pool<32> pool(4);
+	TEST_ASSERT_EQUAL_MESSAGE(4, pool.free_segments(), "segment_pool reserve");
+	{
+		fmt::alloc_scope scope;
+		fmt::basic_segmented_buffer<32> buffer(&pool);
+		fmt::format_to(buffer.out(), "{:>100}", "x");
+		TEST_ASSERT_EQUAL_MESSAGE(100, buffer.total_size(), "segment_pool buffer size");
+		TEST_ASSERT_EQUAL_MESSAGE(0, pool.free_segments(), "segment_pool segments in use");
+		TEST_ASSERT_EQUAL_MESSAGE(0, scope.stats().allocations, "segment_pool no allocations");
+	}
+	TEST_ASSERT_EQUAL_MESSAGE(4, pool.free_segments(), "segment_pool segments returned");
+	{
+		fmt::basic_segmented_buffer<32> buffer(&pool);
+		fmt::format_to(buffer.out(), "{:>200}", "x");
+		TEST_ASSERT_EQUAL_MESSAGE(7, buffer.num_segments(), "segment_pool grows when empty");
+	}
+	TEST_ASSERT_EQUAL_MESSAGE(7, pool.free_segments(), "segment_pool keeps extra segments");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR sinks
+ *----------------------------------------------------------------------------*/
+
+// A fixed-size ring buffer with a block write
+struct ring_sink
+{
+	char data[64];
+	size_t head = 0;
+	size_t size = 0;
+	size_t writes = 0;
+
+	size_t write(const char *s, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+			data[(head + size + i) % sizeof(data)] = s[i];
+		size += n;
+		++writes;
+		return n;
+	}
+
+	std::string str() const
+	{
+		std::string result;
+		for (size_t i = 0; i < size; ++i)
+			result += data[(head + i) % sizeof(data)];
+		return result;
+	}
+};
+
+void test_format_to_sink()
+{
+	ring_sink ring;
+	fmt::format_to<8>(ring, "{}-{:04}-{}", "sensor", 42, 1.5);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("sensor-0042-1.5", ring.str().c_str(), "format_to sink output");
+	TEST_ASSERT_EQUAL_MESSAGE(2, ring.writes, "format_to sink writes whole blocks");
+
+	ring_sink empty;
+	fmt::format_to(empty, "");
+	TEST_ASSERT_EQUAL_MESSAGE(0, empty.writes, "format_to sink no empty writes");
+
+	string_print print;
+	fmt::format_to(print, "{:>40}", "x");
+	TEST_ASSERT_EQUAL_MESSAGE(40, print.output.size(), "format_to Print output");
+	TEST_ASSERT_EQUAL_MESSAGE(1, print.writes, "format_to Print single write");
+}
+
+// A sink that accepts a limited number of characters
+struct limited_sink
+{
+	std::string output;
+	size_t capacity;
+
+	size_t write(const char *s, size_t n)
+	{
+		size_t count = n < capacity - output.size() ? n : capacity - output.size();
+		output.append(s, count);
+		return count;
+	}
+};
+
+void test_format_to_tee()
+{
+	ring_sink ring;
+	string_print print;
+	limited_sink limited{"", 12};
+	auto out = fmt::tee(ring, print, limited);
+	fmt::format_to<8>(out, "{}: {:.2f}", "temperature", 21.456);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("temperature: 21.46", ring.str().c_str(), "tee first sink");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("temperature: 21.46", print.output.c_str(), "tee second sink");
+	TEST_ASSERT_EQUAL_MESSAGE(3, print.writes, "tee forwards blocks");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("temperature:", limited.output.c_str(), "tee failed sink output");
+	TEST_ASSERT_FALSE_MESSAGE(out.failed(0), "tee first sink ok");
+	TEST_ASSERT_FALSE_MESSAGE(out.failed(1), "tee second sink ok");
+	TEST_ASSERT_TRUE_MESSAGE(out.failed(2), "tee third sink failed");
+
+	// A failed sink is skipped until the errors are cleared
+	fmt::format_to(out, "{}", "abc");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("temperature:", limited.output.c_str(), "tee skips failed sink");
+	limited.capacity = 15;
+	out.clear_errors();
+	fmt::format_to(out, "{}", "abc");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("temperature:abc", limited.output.c_str(), "tee clear_errors");
+	TEST_ASSERT_FALSE_MESSAGE(out.any_failed(), "tee no errors");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR checksums
+ *----------------------------------------------------------------------------*/
+
+void test_checksum_algorithms()
+{
+	TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x31, fmt::checksum<fmt::xor8>("123456789"), "xor8 check value");
+	TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x29B1, fmt::checksum<fmt::crc16_ccitt>("123456789"), "crc16_ccitt check value");
+	TEST_ASSERT_EQUAL_HEX32_MESSAGE(0xCBF43926, fmt::checksum<fmt::crc32>("123456789"), "crc32 check value");
+	TEST_ASSERT_EQUAL_HEX32_MESSAGE(0xCBF43926, fmt::checksum<fmt::crc32_slice8>("123456789"), "crc32_slice8 check value");
+	TEST_ASSERT_EQUAL_HEX32_MESSAGE(0, fmt::checksum<fmt::crc32_slice8>(""), "crc32_slice8 empty");
+
+	// Slice-by-8 agrees with the bytewise version for any length and split
+	std::string data;
+	for (int i = 0; i < 100; ++i)
+		data += static_cast<char>(i * 37 + 11);
+	for (size_t split = 0; split < data.size(); split += 7)
+	{
+		fmt::crc32 bytewise;
+		fmt::crc32_slice8 sliced;
+		bytewise.update(data.data(), split);
+		bytewise.update(data.data() + split, data.size() - split);
+		sliced.update(data.data(), split);
+		sliced.update(data.data() + split, data.size() - split);
+		TEST_ASSERT_EQUAL_HEX32_MESSAGE(bytewise.value(), sliced.value(), "crc32_slice8 matches crc32");
+	}
+}
+
+void test_checksum_sink()
+{
+	// NMEA sentence: the checksum covers the text between '$' and '*'
+	string_print print;
+	print.write('$');
+	auto out = fmt::checksummed<fmt::xor8>(print);
+	fmt::format_to<8>(out, "GPGGA,{},{:08.3f},N,{:09.3f},E,{},{:02},{},{:.1f},M,{},M,,", 123519, 4807.038, 1131.0, 1, 8, 0.9, 545.4, 46.9);
+	fmt::format_to(print, "*{:02X}", out.checksum());
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47", print.output.c_str(), "checksummed NMEA sentence");
+
+	ring_sink ring;
+	auto crc = fmt::checksummed<fmt::crc16_ccitt>(ring);
+	fmt::format_to<4>(crc, "{}{}", 1234, 56789);
+	TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x29B1, crc.checksum(), "checksummed crc16 over blocks");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("123456789", ring.str().c_str(), "checksummed sink output");
+	crc.reset();
+	TEST_ASSERT_EQUAL_HEX16_MESSAGE(0xFFFF, crc.checksum(), "checksummed reset");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR compression
+ *----------------------------------------------------------------------------*/
+
+// A sink that appends to a string
+struct string_sink
+{
+	std::string output;
+
+	size_t write(const char *s, size_t n)
+	{
+		output.append(s, n);
+		return n;
+	}
+};
+
+void test_compressed_round_trip()
+{
+	string_sink compressed;
+	auto out = fmt::compressed(compressed);
+	std::string expected;
+	for (int i = 0; i < 200; ++i)
+	{
+		const char *level = i % 7 == 0 ? "WARN" : "INFO";
+		fmt::format_to<32>(out, "{:08} {} sensor {} temperature={:.1f}C\n", 1000 + i * 250, level, i % 4, 20 + (i % 13) * 0.3);
+		expected += fmt::format("{:08} {} sensor {} temperature={:.1f}C\n", 1000 + i * 250, level, i % 4, 20 + (i % 13) * 0.3);
+	}
+	out.finish();
+	TEST_ASSERT_EQUAL_MESSAGE(expected.size(), out.bytes_in(), "lzss bytes_in");
+	TEST_ASSERT_EQUAL_MESSAGE(compressed.output.size(), out.bytes_out(), "lzss bytes_out");
+	TEST_ASSERT_TRUE_MESSAGE(out.bytes_out() * 2 < out.bytes_in(), "lzss compresses log lines");
+
+	// Decode in blocks of different sizes
+	for (size_t block = 1; block < 20; block += 6)
+	{
+		string_sink decompressed;
+		fmt::lzss_decoder<string_sink> decoder(decompressed);
+		for (size_t i = 0; i < compressed.output.size(); i += block)
+			decoder.write(compressed.output.data() + i, std::min(block, compressed.output.size() - i));
+		decoder.finish();
+		TEST_ASSERT_TRUE_MESSAGE(expected == decompressed.output, "lzss round trip");
+	}
+}
+
+void test_compressed_incompressible()
+{
+	std::string data;
+	uint32_t state = 12345;
+	for (int i = 0; i < 1000; ++i)
+	{
+		state = state * 1103515245 + 12345;
+		data += static_cast<char>(state >> 16);
+	}
+	string_sink compressed;
+	fmt::lzss_sink<string_sink, 10, 5> out(compressed);
+	fmt::format_to(out, "{}{}", data, std::string(300, 'x'));
+	out.finish();
+	TEST_ASSERT_TRUE_MESSAGE(compressed.output.size() < data.size() * 9 / 8 + 40, "lzss bounded expansion");
+
+	string_sink decompressed;
+	fmt::lzss_decoder<string_sink, 10, 5> decoder(decompressed);
+	decoder.write(compressed.output.data(), compressed.output.size());
+	decoder.finish();
+	TEST_ASSERT_TRUE_MESSAGE(data + std::string(300, 'x') == decompressed.output, "lzss round trip incompressible");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR framing
+ *----------------------------------------------------------------------------*/
+
+// Decodes a COBS frame including the zero delimiter
+std::string cobs_decode(const std::string &frame)
+{
+	std::string result;
+	size_t i = 0;
+	while (i < frame.size() && frame[i] != '\0')
+	{
+		unsigned code = static_cast<unsigned char>(frame[i++]);
+		for (unsigned j = 1; j < code; ++j)
+			result += frame[i++];
+		if (code != 0xFF && frame[i] != '\0')
+			result += '\0';
+	}
+	return result;
+}
+
+void test_cobs_sink()
+{
+	string_sink out;
+	auto frame = fmt::cobs_sink<string_sink>(out);
+	fmt::format_to(frame, "{}{}{}", '\x11', '\x22', '\0');
+	fmt::format_to(frame, "{}", '\x33');
+	frame.finish();
+	TEST_ASSERT_TRUE_MESSAGE(std::string("\x03\x11\x22\x02\x33\x00", 6) == out.output, "cobs small frame");
+
+	out.output.clear();
+	frame.finish();
+	TEST_ASSERT_TRUE_MESSAGE(std::string("\x01\x00", 2) == out.output, "cobs empty frame");
+
+	// Blocks of 254 bytes have no implicit zero
+	std::string data;
+	for (int i = 0; i < 254; ++i)
+		data += static_cast<char>(i + 1);
+	out.output.clear();
+	fmt::format_to<16>(frame, "{}", data);
+	frame.finish();
+	TEST_ASSERT_EQUAL_MESSAGE(256, out.output.size(), "cobs full block size");
+	TEST_ASSERT_EQUAL_HEX8_MESSAGE(0xFF, static_cast<unsigned char>(out.output[0]), "cobs full block code");
+	TEST_ASSERT_TRUE_MESSAGE(data == cobs_decode(out.output), "cobs full block round trip");
+
+	std::string mixed;
+	for (int i = 0; i < 1000; ++i)
+		mixed += static_cast<char>(i % 300 == 0 ? 0 : i * 7);
+	out.output.clear();
+	fmt::format_to<16>(frame, "{}", mixed);
+	frame.finish();
+	TEST_ASSERT_EQUAL_MESSAGE(1, std::count(out.output.begin(), out.output.end(), '\0'), "cobs only delimiter is zero");
+	TEST_ASSERT_TRUE_MESSAGE(mixed == cobs_decode(out.output), "cobs round trip");
+}
+
+void test_slip_sink()
+{
+	string_sink out;
+	auto frame = fmt::slip_sink<string_sink>(out);
+	fmt::format_to(frame, "a{}b{}c", '\xC0', '\xDB');
+	frame.finish();
+	TEST_ASSERT_TRUE_MESSAGE(std::string("a\xDB\xDC" "b\xDB\xDD" "c\xC0") == out.output, "slip escapes");
+
+	out.output.clear();
+	fmt::format_to(frame, "{:>100}", "x");
+	frame.finish();
+	TEST_ASSERT_EQUAL_MESSAGE(101, out.output.size(), "slip long frame");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR base64 and hex
+ *----------------------------------------------------------------------------*/
+
+void test_base64_format()
+{
+	// RFC 4648 test vectors
+	const char *vectors[][2] = {{"", ""}, {"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"}, {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"}};
+	for (auto &v : vectors)
+	{
+		std::string result = fmt::format("{}", fmt::base64(std::string(v[0])));
+		TEST_ASSERT_EQUAL_STRING_MESSAGE(v[1], result.c_str(), "base64 RFC 4648 vector");
+	}
+
+	uint8_t key[] = {0xfb, 0xff, 0xbf, 0x00, 0x10};
+	std::string result = fmt::format("{}|{}", fmt::base64(key), fmt::base64url(key));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("+/+/ABA=|-_-_ABA", result.c_str(), "base64 and base64url alphabets");
+
+	result = fmt::format("[{:*^12}]", fmt::base64(key));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("[**+/+/ABA=**]", result.c_str(), "base64 padding");
+
+	// Large input through a fixed-size output that can't be written in place
+	std::vector<uint8_t> data(1000);
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<uint8_t>(i * 31);
+	std::string expected = fmt::format("{}", fmt::base64(data));
+	char out[2000];
+	auto r = fmt::format_to_n(out, sizeof(out), "{}", fmt::base64(data));
+	TEST_ASSERT_EQUAL_MESSAGE(expected.size(), r.size, "base64 size through iterator buffer");
+	TEST_ASSERT_TRUE_MESSAGE(expected == std::string(out, r.size), "base64 through iterator buffer");
+}
+
+void test_hex_format()
+{
+	uint8_t data[] = {0x00, 0x1f, 0xa0, 0xff};
+	std::string result = fmt::format("{} {:X} {:>10x}", fmt::hex(data), fmt::hex(data), fmt::hex(data, 2));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("001fa0ff 001FA0FF       001f", result.c_str(), "hex format");
+
+	std::vector<uint8_t> large(300, 0xab);
+	char out[700];
+	auto r = fmt::format_to_n(out, sizeof(out), "{:X}", fmt::hex(large));
+	TEST_ASSERT_EQUAL_MESSAGE(600, r.size, "hex large size");
+	std::string expected;
+	for (size_t i = 0; i < large.size(); ++i)
+		expected += "AB";
+	TEST_ASSERT_TRUE_MESSAGE(expected == std::string(out, r.size), "hex large output");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR hashing
+ *----------------------------------------------------------------------------*/
+
+void test_hash_algorithms()
+{
+	TEST_ASSERT_EQUAL_HEX32_MESSAGE(0xe40c292c, fmt::format_hash<fmt::fnv1a_32>("a"), "fnv1a_32 vector");
+	TEST_ASSERT_TRUE_MESSAGE(0xaf63dc4c8601ec8cull == fmt::format_hash<fmt::fnv1a_64>("a"), "fnv1a_64 vector");
+	TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x02CC5D05, fmt::format_hash<fmt::xxh32>(""), "xxh32 empty");
+	TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x32D153FF, fmt::format_hash<fmt::xxh32>("abc"), "xxh32 abc");
+	TEST_ASSERT_TRUE_MESSAGE(0xEF46DB3751D8E999ull == fmt::format_hash<fmt::xxh64>(""), "xxh64 empty");
+	TEST_ASSERT_TRUE_MESSAGE(0x44BC2CF5AD770999ull == fmt::format_hash<fmt::xxh64>("abc"), "xxh64 abc");
+
+	// The result doesn't depend on how the input is split
+	std::string data;
+	for (int i = 0; i < 200; ++i)
+		data += static_cast<char>(i * 13 + 7);
+	fmt::xxh32 whole32;
+	fmt::xxh64 whole64;
+	whole32.update(data.data(), data.size());
+	whole64.update(data.data(), data.size());
+	for (size_t step = 1; step < 40; step += 6)
+	{
+		fmt::xxh32 split32;
+		fmt::xxh64 split64;
+		for (size_t i = 0; i < data.size(); i += step)
+		{
+			split32.update(data.data() + i, std::min(step, data.size() - i));
+			split64.update(data.data() + i, std::min(step, data.size() - i));
+		}
+		TEST_ASSERT_EQUAL_HEX32_MESSAGE(whole32.value(), split32.value(), "xxh32 incremental");
+		TEST_ASSERT_TRUE_MESSAGE(whole64.value() == split64.value(), "xxh64 incremental");
+	}
+}
+
+void test_format_hash()
+{
+	std::string message = fmt::format("{} sensor {} temperature={:.1f}C {:>40}", "WARN", 3, 21.55, "overheating");
+	fmt::xxh64 expected;
+	expected.update(message.data(), message.size());
+	TEST_ASSERT_TRUE_MESSAGE(expected.value() == (fmt::format_hash<fmt::xxh64, 16>("{} sensor {} temperature={:.1f}C {:>40}", "WARN", 3, 21.55, "overheating")), "format_hash matches hash of output");
+
+	fmt::alloc_scope scope;
+	uint32_t crc = fmt::format_hash<fmt::crc32>("{:>300}", 123456789);
+	TEST_ASSERT_EQUAL_MESSAGE(0, scope.stats().allocations, "format_hash doesn't allocate");
+	TEST_ASSERT_EQUAL_HEX32_MESSAGE(fmt::checksum<fmt::crc32>(fmt::format("{:>300}", 123456789)), crc, "format_hash with a checksum");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR JSON
+ *----------------------------------------------------------------------------*/
+
+struct json_point
+{
+	int x, y;
+};
+
+template <>
+struct fmt::json_writer<json_point>
+{
+	static auto write(fmt::appender out, const json_point &p) -> fmt::appender
+	{
+		return fmt::format_to(out, R"({{"x":{},"y":{}}})", p.x, p.y);
+	}
+};
+
+void test_json_scalars()
+{
+	std::string result = fmt::format("{} {} {} {} {} {} {}", fmt::json(true), fmt::json(-42), fmt::json(uint8_t(200)), fmt::json(1.5), fmt::json(std::numeric_limits<double>::infinity()), fmt::json(nullptr), fmt::json('c'));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("true -42 200 1.5 null null \"c\"", result.c_str(), "json scalars");
+
+	result = fmt::format("{}", fmt::json("tab\there \"quoted\" back\\slash\n\x01 caf\xc3\xa9 and a long tail without escapes"));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("\"tab\\there \\\"quoted\\\" back\\\\slash\\n\\u0001 caf\xc3\xa9 and a long tail without escapes\"", result.c_str(), "json string escapes");
+
+	String arduino("line\r\n");
+	result = fmt::format("{}", fmt::json(arduino));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("\"line\\r\\n\"", result.c_str(), "json Arduino String");
+
+	const char *missing = nullptr;
+	result = fmt::format("{}", fmt::json(missing));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("null", result.c_str(), "json null string pointer");
+
+	// Escapes at every position of a machine word
+	for (size_t pos = 0; pos < 20; ++pos)
+	{
+		std::string input(20, 'a');
+		input[pos] = '"';
+		std::string expected = "\"" + input.substr(0, pos) + "\\\"" + input.substr(pos + 1) + "\"";
+		TEST_ASSERT_TRUE_MESSAGE(expected == fmt::format("{}", fmt::json(input)), "json escape position");
+	}
+}
+
+void test_json_containers()
+{
+	std::vector<int> empty;
+	std::vector<std::string> names = {"a", "b\"c"};
+	std::map<std::string, std::vector<double>> readings = {{"t", {20.5, 21}}, {"h", {}}};
+	std::map<int, bool> flags = {{1, true}, {2, false}};
+	auto tuple = std::make_tuple(1, "two", 3.5, std::make_pair('x', json_point{1, 2}));
+	std::string result = fmt::format("{}|{}|{}|{}|{}", fmt::json(empty), fmt::json(names), fmt::json(readings), fmt::json(flags), fmt::json(tuple));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("[]|[\"a\",\"b\\\"c\"]|{\"h\":[],\"t\":[20.5,21]}|{\"1\":true,\"2\":false}|[1,\"two\",3.5,[\"x\",{\"x\":1,\"y\":2}]]", result.c_str(), "json containers");
+
+	int values[] = {1, 2, 3};
+	result = fmt::format(R"({{"id":{},"values":{}}})", fmt::json("sensor"), fmt::json(values));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("{\"id\":\"sensor\",\"values\":[1,2,3]}", result.c_str(), "json in a format string");
+
+#if FMT_JSON_OPTIONAL
+	std::vector<std::optional<int>> optionals = {1, std::nullopt};
+	result = fmt::format("{}", fmt::json(optionals));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("[1,null]", result.c_str(), "json optionals");
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR CSV ROWS
+ *----------------------------------------------------------------------------*/
+
+void test_csv_row()
+{
+	auto row = fmt::csv_row(FMT_COMPILE("{}"), FMT_COMPILE("{:.2f}"), FMT_COMPILE("{}"), FMT_COMPILE("{:>4}"));
+	fmt::memory_buffer buf;
+	row.format_to(buf, 1, 21.456, "plain", 7);
+	row.format_to(buf, 2, -1.0, std::string("a,b"), 8);
+	row.format_to(buf, 3, 0.5, "say \"hi\"", 9);
+	row.format_to(buf, 4, 0.0, String("two\nlines"), 10);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("1,21.46,plain,   7\r\n2,-1.00,\"a,b\",   8\r\n3,0.50,\"say \"\"hi\"\"\",   9\r\n4,0.00,\"two\nlines\",  10\r\n", fmt::to_string(buf).c_str(), "csv rows");
+
+	// Quoting at every position of a machine word
+	auto single = fmt::csv_row(FMT_COMPILE("{}"));
+	for (size_t pos = 0; pos < 20; ++pos)
+	{
+		std::string input(20, 'a');
+		input[pos] = '"';
+		buf.clear();
+		single.format_to(buf, input);
+		std::string expected = "\"" + input.substr(0, pos) + "\"\"" + input.substr(pos + 1) + "\"\r\n";
+		TEST_ASSERT_TRUE_MESSAGE(expected == fmt::to_string(buf), "csv quote position");
+	}
+}
+
+void test_csv_row_options()
+{
+	auto row = fmt::csv_row(FMT_COMPILE("{}"), FMT_COMPILE("{}"));
+	row.separator(';').line_end("\n");
+	fmt::memory_buffer buf;
+	row.format_to(buf, "a,b", "c;d");
+	row.format_to(buf, 1.5, 2);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("a,b;\"c;d\"\n1.5;2\n", fmt::to_string(buf).c_str(), "csv separator and line end");
+
+	// Fields of any type are quoted if needed
+	auto mixed = fmt::csv_row(FMT_COMPILE("{}"), FMT_COMPILE("{},x"), FMT_COMPILE("{}"));
+	buf.clear();
+	mixed.format_to(buf, ',', 1, 2);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("\",\",\"1,x\",2\r\n", fmt::to_string(buf).c_str(), "csv quotes characters and format strings");
+
+	// Growing the buffer while a field is quoted
+	auto quoted = fmt::csv_row(FMT_COMPILE("{}"));
+	fmt::basic_memory_buffer<char, 4> small;
+	quoted.format_to(small, "\"\"\"");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("\"\"\"\"\"\"\"\"\r\n", fmt::to_string(small).c_str(), "csv quoting grows the buffer");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR LOGFMT
+ *----------------------------------------------------------------------------*/
+
+void test_logfmt()
+{
+	using namespace fmt::literals;
+	std::string result = fmt::format("{}", fmt::logfmt("level"_a = "info", "t"_a = 1234, "temp"_a = 21.5, "ok"_a = true, fmt::arg("msg", "sensor ready")));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("level=info t=1234 temp=21.5 ok=true msg=\"sensor ready\"", result.c_str(), "logfmt pairs");
+
+	String path("C:\\logs");
+	result = fmt::format("[{}]", fmt::logfmt("empty"_a = "", "eq"_a = "a=b", "quote"_a = "say \"hi\"", "path"_a = path, "lines"_a = std::string("one\ntwo\x01")));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("[empty=\"\" eq=\"a=b\" quote=\"say \\\"hi\\\"\" path=C:\\logs lines=\"one\\ntwo\\u0001\"]", result.c_str(), "logfmt quoting");
+
+	// Quoting at every position of a machine word
+	for (size_t pos = 0; pos < 20; ++pos)
+	{
+		std::string input(20, 'a');
+		input[pos] = ' ';
+		std::string expected = "k=\"" + input + "\"";
+		TEST_ASSERT_TRUE_MESSAGE(expected == fmt::format("{}", fmt::logfmt(fmt::arg("k", input))), "logfmt quote position");
+	}
+
+	// Outputs that are flushed while a value is written
+	String line;
+	fmt::format_to(line, "{:>{}}{}", "", 60, fmt::logfmt("level"_a = "info", "msg"_a = "sensor ready now"));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE((std::string(60, ' ') + "level=info msg=\"sensor ready now\"").c_str(), line.c_str(), "logfmt to String");
+	string_sink sink;
+	fmt::format_to<16>(sink, "{}", fmt::logfmt("level"_a = "info", "msg"_a = "sensor ready now", "x"_a = "a b"));
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("level=info msg=\"sensor ready now\" x=\"a b\"", sink.output.c_str(), "logfmt to sink");
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR SCANNING
+ *----------------------------------------------------------------------------*/
+
+// A stream with the readBytesUntil function of Arduino's Stream class
+struct string_stream
+{
+	std::string input;
+	size_t pos = 0;
+
+	size_t readBytesUntil(char terminator, char *buffer, size_t length)
+	{
+		size_t n = 0;
+		while (n < length && pos < input.size())
+		{
+			char c = input[pos++];
+			if (c == terminator)
+				break;
+			buffer[n++] = c;
+		}
+		return n;
+	}
+};
+
+void test_scan_numbers()
+{
+	int channel = 0;
+	unsigned mask = 0;
+	float level = 0;
+	auto result = fmt::scan("SET 3 0x1F -2.5e1", "SET {} {:x} {}", channel, mask, level);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result), "scan succeeds");
+	TEST_ASSERT_EQUAL_MESSAGE(3, result.count, "scan count");
+	TEST_ASSERT_EQUAL_MESSAGE(3, channel, "scan int");
+	TEST_ASSERT_EQUAL_MESSAGE(0x1f, mask, "scan hex");
+	TEST_ASSERT_EQUAL_FLOAT_MESSAGE(-25.0f, level, "scan float");
+
+	uint8_t bits = 0;
+	int16_t small = 0;
+	long long big = 0;
+	double value = 0;
+	result = fmt::scan("101 -32768 -9223372036854775808 0.1", "{:b}{}{}{}", bits, small, big, value);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result), "scan limits");
+	TEST_ASSERT_EQUAL_MESSAGE(5, bits, "scan binary");
+	TEST_ASSERT_EQUAL_MESSAGE(-32768, small, "scan int16_t");
+	TEST_ASSERT_TRUE_MESSAGE(big == std::numeric_limits<long long>::min(), "scan long long");
+	TEST_ASSERT_TRUE_MESSAGE(value == 0.1, "scan double");
+
+	int a = 0, b = 0;
+	result = fmt::scan("12345", "{:2}{:3}", a, b);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && a == 12 && b == 345, "scan width");
+
+	result = fmt::scan("300", "{}", bits);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == fmt::scan_errc::out_of_range && bits == 5, "scan out of range");
+	result = fmt::scan("-1", "{}", mask);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == fmt::scan_errc::out_of_range, "scan negative unsigned");
+	fmt::string_view input = "7 x";
+	result = fmt::scan(input, "{} {}", a, b);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == fmt::scan_errc::invalid_input && result.count == 1 && a == 7, "scan invalid input");
+	TEST_ASSERT_EQUAL_MESSAGE(2, result.end - input.data(), "scan stops at the mismatch");
+
+	// The float presentation types select the accepted forms
+	result = fmt::scan("2.5e1", "{:e}", value);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && value == 25, "scan e");
+	result = fmt::scan("2.5", "{:e}", value);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == fmt::scan_errc::invalid_input, "scan e requires an exponent");
+	result = fmt::scan("1.5e3", "{:f}e{}", value, a);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && value == 1.5 && a == 3, "scan f stops before an exponent");
+	result = fmt::scan("1.5e3", "{:g}", value);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && value == 1500, "scan g");
+	const char *message = fmt::detail::trap_errors([] {
+		double d = 0;
+		fmt::scan("0x1p3", fmt::runtime("{:a}"), d);
+	});
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("invalid scan specifier", message, "scan rejects hex floats");
+}
+
+void test_scan_strings()
+{
+	fmt::string_view key;
+	int value = 0;
+	fmt::string_view input = "speed=42 rest";
+	auto result = fmt::scan(input, "{}={}", key, value);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && key == "speed" && value == 42, "scan key=value");
+	TEST_ASSERT_TRUE_MESSAGE(fmt::string_view(result.end) == " rest", "scan end position");
+
+	char name[8];
+	char sep = 0;
+	result = fmt::scan("  led:on", "{}{}{}", name, sep, key);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == fmt::scan_errc::invalid_input, "scan string without terminator");
+	result = fmt::scan("  led:on", "{}:{}", name, key);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && std::string(name) == "led" && key == "on", "scan char array");
+	result = fmt::scan("a,b", "{}{}", sep, key);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && sep == 'a' && key == ",b", "scan char");
+	result = fmt::scan("toolongname", "{}", name);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == fmt::scan_errc::out_of_range, "scan char array overflow");
+	result = fmt::scan("{x}", "{{{}}}", sep);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && sep == 'x', "scan escaped braces");
+
+	string_stream serial;
+	serial.input = "MOVE 10 -20\r\nNEXT";
+	char line[32];
+	int x = 0, y = 0;
+	result = fmt::scan_line(serial, line, "MOVE {} {}", x, y);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && x == 10 && y == -20, "scan line");
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("MOVE 10 -20", line, "scan line buffer");
+
+#if FMT_USE_EXCEPTIONS
+	bool thrown = false;
+	try
+	{
+		fmt::scan("1", fmt::runtime("{:+}"), x);
+	}
+	catch (const fmt::format_error &)
+	{
+		thrown = true;
+	}
+	TEST_ASSERT_TRUE_MESSAGE(thrown, "scan invalid specifier");
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ * TESTS FOR FROM_CHARS
+ *----------------------------------------------------------------------------*/
+
+template <typename T>
+fmt::from_chars_result parse(fmt::string_view s, T &value)
+{
+	return fmt::from_chars(s.begin(), s.end(), value);
+}
+
+template <typename T>
+bool same_bits(T a, T b)
+{
+	return memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+void test_from_chars_integers()
+{
+	int i = 0;
+	auto result = parse("-1234 rest", i);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && i == -1234, "from_chars int");
+	TEST_ASSERT_TRUE_MESSAGE(fmt::string_view(result.ptr) == " rest", "from_chars int end");
+
+	uint8_t u8 = 0;
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("255", u8)) && u8 == 255, "from_chars uint8_t");
+	result = parse("256", u8);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == std::errc::result_out_of_range && u8 == 255, "from_chars uint8_t overflow");
+	result = parse("-1", u8);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == std::errc::invalid_argument, "from_chars negative unsigned");
+
+	int8_t i8 = 0;
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("-128", i8)) && i8 == -128, "from_chars int8_t min");
+	TEST_ASSERT_TRUE_MESSAGE(parse("128", i8).ec == std::errc::result_out_of_range, "from_chars int8_t overflow");
+
+	long long ll = 0;
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("-9223372036854775808", ll)) && ll == std::numeric_limits<long long>::min(), "from_chars long long min");
+	unsigned long long ull = 0;
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("18446744073709551615", ull)) && ull == ~0ull, "from_chars unsigned long long max");
+	TEST_ASSERT_TRUE_MESSAGE(parse("18446744073709551616", ull).ec == std::errc::result_out_of_range, "from_chars unsigned long long overflow");
+
+	fmt::string_view hex = "fF7g";
+	unsigned u = 0;
+	result = fmt::from_chars(hex.begin(), hex.end(), u, 16);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && u == 0xff7 && result.ptr == hex.begin() + 3, "from_chars base 16");
+	fmt::string_view z = "zz";
+	TEST_ASSERT_TRUE_MESSAGE(bool(fmt::from_chars(z.begin(), z.end(), u, 36)) && u == 35 * 36 + 35, "from_chars base 36");
+	TEST_ASSERT_TRUE_MESSAGE(parse("+1", i).ec == std::errc::invalid_argument, "from_chars plus sign");
+	TEST_ASSERT_TRUE_MESSAGE(parse("", i).ec == std::errc::invalid_argument, "from_chars empty");
+}
+
+void test_from_chars_floats()
+{
+	double d = 0;
+	auto result = parse("0.1", d);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && d == 0.1, "from_chars 0.1");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("-2.5e-3x", d)) && d == -2.5e-3, "from_chars exponent");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("1.7976931348623157e308", d)) && d == std::numeric_limits<double>::max(), "from_chars max");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("4.9406564584124654e-324", d)) && d == std::numeric_limits<double>::denorm_min(), "from_chars min subnormal");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("1e-320", d)) && d == 1e-320, "from_chars subnormal");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("2.4703282292062329e-324", d)) && d == std::numeric_limits<double>::denorm_min(), "from_chars rounds up to min subnormal");
+	d = 1;
+	TEST_ASSERT_TRUE_MESSAGE(parse("2.4703282292062327e-324", d).ec == std::errc::result_out_of_range && d == 1, "from_chars underflow");
+	TEST_ASSERT_TRUE_MESSAGE(parse("2e-324", d).ec == std::errc::result_out_of_range && d == 1, "from_chars underflow below half");
+	TEST_ASSERT_TRUE_MESSAGE(parse("1e-400", d).ec == std::errc::result_out_of_range && d == 1, "from_chars underflow far");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("0e-400", d)) && d == 0, "from_chars zero with small exponent");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("-0", d)) && same_bits(d, -0.0), "from_chars negative zero");
+
+	// Halfway between 2^53 and 2^53 + 2 rounds to even, more digits round up.
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("9007199254740993", d)) && d == 9007199254740992.0, "from_chars halfway");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("9007199254740993.00000000000000000000001", d)) && d == 9007199254740994.0, "from_chars above halfway");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("123456789012345678901234567890", d)) && d == 123456789012345678901234567890.0, "from_chars many digits");
+
+	result = parse("1e400", d);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == std::errc::result_out_of_range && d == 123456789012345678901234567890.0, "from_chars overflow");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("-Infinity", d)) && d == -std::numeric_limits<double>::infinity(), "from_chars infinity");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("nan(1)", d)) && d != d, "from_chars nan");
+	TEST_ASSERT_TRUE_MESSAGE(parse(".e1", d).ec == std::errc::invalid_argument, "from_chars no digits");
+
+	fmt::string_view s = "1.5e3";
+	result = fmt::from_chars(s.begin(), s.end(), d, fmt::chars_format::fixed);
+	TEST_ASSERT_TRUE_MESSAGE(bool(result) && d == 1.5 && result.ptr == s.begin() + 3, "from_chars fixed");
+	result = fmt::from_chars(s.begin(), s.begin() + 3, d, fmt::chars_format::scientific);
+	TEST_ASSERT_TRUE_MESSAGE(result.ec == std::errc::invalid_argument, "from_chars scientific");
+
+	float f = 0;
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("3.4028235e38", f)) && f == std::numeric_limits<float>::max(), "from_chars float max");
+	TEST_ASSERT_TRUE_MESSAGE(parse("3.4028236e38", f).ec == std::errc::result_out_of_range, "from_chars float overflow");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("1.00000005960464477539062501", f)) && f == 1.00000012f, "from_chars float above halfway");
+	TEST_ASSERT_TRUE_MESSAGE(bool(parse("1.4e-45", f)) && f == std::numeric_limits<float>::denorm_min(), "from_chars float subnormal");
+	TEST_ASSERT_TRUE_MESSAGE(parse("7e-46", f).ec == std::errc::result_out_of_range, "from_chars float underflow");
+	TEST_ASSERT_TRUE_MESSAGE(parse("1e39", f).ec == std::errc::result_out_of_range, "from_chars float overflow far");
+}
+
 /*------------------------------------------------------------------------------
  * SETUP AND TEST RUNNER
  *----------------------------------------------------------------------------*/
@@ -566,6 +1993,8 @@ void tests()
 
 	// Arduino String formatter tests
 	RUN_TEST(test_arduino_string_formatter);
+	RUN_TEST(test_format_to_arduino_string);
+	RUN_TEST(test_printable_formatter);
 
 	// Specific scenario tests
 	RUN_TEST(test_sensor_data_formatting);
@@ -573,6 +2002,94 @@ void tests()
 	RUN_TEST(test_json_like_formatting);
 	RUN_TEST(test_hex_dump_formatting);
 	RUN_TEST(test_timestamp_formatting);
+
+	// named_format tests
+	RUN_TEST(test_named_arguments);
+	RUN_TEST(test_named_format_basic);
+	RUN_TEST(test_named_format_mixed_and_dynamic_specs);
+	RUN_TEST(test_named_format_many_names);
+
+	// arena_format_arg_store tests
+	RUN_TEST(test_arena_args_basic);
+	RUN_TEST(test_arena_args_named_and_custom);
+	RUN_TEST(test_arena_args_reuse);
+
+	// try_ formatting function tests
+	RUN_TEST(test_try_format_to_n_ok);
+	RUN_TEST(test_try_format_to_n_error);
+	RUN_TEST(test_try_vformat_to_buffer);
+
+	// format_truncated tests
+	RUN_TEST(test_format_truncated_fits);
+	RUN_TEST(test_format_truncated_stops_early);
+	RUN_TEST(test_format_truncated_ellipsis);
+
+	// Scratch buffer tests
+	RUN_TEST(test_scratch_buffer_reuse);
+	RUN_TEST(test_scratch_buffer_nested);
+
+	// Flash format string tests
+	RUN_TEST(test_flash_format_string);
+	RUN_TEST(test_flash_format_errors);
+	RUN_TEST(test_flash_string_argument);
+
+	// Table lookup tests
+	RUN_TEST(test_table_lookup_output);
+
+	// Stack usage tests
+	RUN_TEST(test_measure_stack_usage);
+
+	// Allocation statistics tests
+	RUN_TEST(test_alloc_stats);
+	RUN_TEST(test_alloc_budget);
+	RUN_TEST(test_alloc_budget_memory_buffer);
+
+	// Segmented buffer tests
+	RUN_TEST(test_segmented_buffer);
+	RUN_TEST(test_segment_pool);
+
+	// Sink tests
+	RUN_TEST(test_format_to_sink);
+	RUN_TEST(test_format_to_tee);
+
+	// Checksum tests
+	RUN_TEST(test_checksum_algorithms);
+	RUN_TEST(test_checksum_sink);
+
+	// Compression tests
+	RUN_TEST(test_compressed_round_trip);
+	RUN_TEST(test_compressed_incompressible);
+
+	// Framing tests
+	RUN_TEST(test_cobs_sink);
+	RUN_TEST(test_slip_sink);
+
+	// Encoding tests
+	RUN_TEST(test_base64_format);
+	RUN_TEST(test_hex_format);
+
+	// Hashing tests
+	RUN_TEST(test_hash_algorithms);
+	RUN_TEST(test_format_hash);
+
+	// JSON tests
+	RUN_TEST(test_json_scalars);
+	RUN_TEST(test_json_containers);
+
+	// CSV tests
+	RUN_TEST(test_csv_row);
+	RUN_TEST(test_csv_row_options);
+
+	// logfmt tests
+	RUN_TEST(test_logfmt);
+
+	// Scanning tests
+	RUN_TEST(test_scan_numbers);
+	RUN_TEST(test_scan_strings);
+
+	// from_chars tests
+	RUN_TEST(test_from_chars_integers);
+	RUN_TEST(test_from_chars_floats);
 }
 
 void setup()